@@ -0,0 +1,506 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+#include "app_context.h"
+#include "frame_stats.h"
+#include "program_cache.h"
+#include "shader_c.h"
+#include "camera3.h"
+#include "sphere_scene.h"
+#include "bvh.h"
+#include "frame_params.h"
+#include "uniform_ring.h"
+#include "ray_packet.h"
+#include "tile_renderer.h"
+#include "output_image.h"
+#include "presenter.h"
+#include "pixel_order.h"
+#include "perf_counters.h"
+
+// Benchmark de todas las cargas del repo con frames fijos y calentamiento previo.
+// Cada frame de GPU termina con glFinish, así el tiempo medido es el frame completo.
+// El resultado (min/mediana/p99 y píxeles/s por carga) sale en JSON por stdout o a --output.
+// "startup" mide la creación de cada ComputeShader compilando desde el código (frío)
+// y cargando el binario de ProgramCache (caliente). "formats" corre el gradiente en 4K
+// con cada formato de imagen de salida y da el ancho de banda de escritura de la imagen.
+// "present" corre la luz de test3 y la muestra con cada modo de Presenter (blit, quad
+// y readback), así el tiempo incluye llevar la imagen a la ventana.
+// "order" corre light, spheres y cpu_raytrace en 4K por filas y en orden Morton
+// (pixel_order.h); en la CPU añade los fallos de caché por frame si perf los da.
+// Uso: ./bench [gradient] [light] [spheres] [cpu_raytrace] [startup] [formats] [present] [order] [--frames N] [--warmup N]
+//              [--spheres N] [--size 1920x1080] [--headless] [--output resultado.json]
+
+const int SCR_WIDTH = 800;
+const int SCR_HEIGHT = 600;
+const int TEXTURE_WIDTH = 1000;
+const int TEXTURE_HEIGHT = 1000;
+const int FORMATS_WIDTH = 3840;
+const int FORMATS_HEIGHT = 2160;
+const int ORDER_WIDTH = 3840;
+const int ORDER_HEIGHT = 2160;
+const int DEFAULT_WARMUP = 20;
+const int STARTUP_REPEATS = 5;
+const char* STARTUP_SHADERS[] = { "computeShader.cs", "computeShader2.cs", "computeSh_test6.cs" };
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    int frames = RunOptions::DEFAULT_HEADLESS_FRAMES;
+    int warmup = DEFAULT_WARMUP;
+    int spheres = 0;    // 0: escena por defecto de test6/test7
+    int width = 0;      // --size: misma resolución para todas las cargas (0: la de cada una)
+    int height = 0;
+};
+
+struct BenchResult {
+    std::string name;
+    int width, height;
+    FrameStats stats;
+    int imageBytesPerPixel = 0;    // "formats": bytes escritos por píxel en la imagen
+    bool cacheCounters = false;    // "order" en la CPU, si perf_event_open funciona
+    double cacheReferences = 0.0;  // por frame
+    double cacheMisses = 0.0;
+};
+
+struct StartupResult {
+    std::string shader;
+    FrameStats cold;    // compilado desde el código
+    FrameStats warm;    // cargado desde ProgramCache
+};
+
+// Corre warmup + frames veces frame(i) y guarda el tiempo de los frames medidos.
+// Con counters, cuenta durante los frames medidos
+template <typename F>
+FrameStats measure(const BenchConfig& config, bool gpu, F frame, PerfCounters* counters = nullptr) {
+    FrameStats stats;
+    for (int i = 0; i < config.warmup + config.frames; i++) {
+        if (counters && i == config.warmup)
+            counters->start();
+        Clock::time_point start = Clock::now();
+        frame(i);
+        if (gpu)
+            glFinish();
+        if (i >= config.warmup)
+            stats.add(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    if (counters)
+        counters->stop();
+    return stats;
+}
+
+// Imagen de salida en la unidad 0; el shader se compila con image.defines()
+void createImage(OutputImage& image, int width, int height, ImageFormat format) {
+    image.create(width, height, format);
+    image.bindImage(0);
+}
+
+SphereScene benchScene(const BenchConfig& config) {
+    return config.spheres > 0 ? SphereScene::random(config.spheres) : SphereScene::defaultScene();
+}
+
+// computeShader.cs, igual que main.cpp
+BenchResult benchGradient(const BenchConfig& config) {
+    int width = config.width ? config.width : TEXTURE_WIDTH;
+    int height = config.height ? config.height : TEXTURE_HEIGHT;
+    OutputImage image;
+    createImage(image, width, height, ImageFormat::RGBA8);
+    ComputeShader computeShader(ProgramBuilder::compute("computeShader.cs", image.defines()));
+    computeShader.use();
+    FrameStats stats = measure(config, true, [&](int frame) {
+        computeShader.setFloat("t", frame / 60.0f);
+        computeShader.dispatchFor(width, height);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    });
+    image.release();
+    glDeleteProgram(computeShader.ID);
+    return { "gradient", width, height, stats };
+}
+
+// computeShader.cs en cada formato de salida: el kernel apenas calcula, así que
+// el tiempo es sobre todo la escritura de la imagen
+std::vector<BenchResult> benchFormats(const BenchConfig& config) {
+    int width = config.width ? config.width : FORMATS_WIDTH;
+    int height = config.height ? config.height : FORMATS_HEIGHT;
+    printImageFootprint(std::cerr, width, height);
+    std::vector<BenchResult> results;
+    for (ImageFormat format : { ImageFormat::RGBA8, ImageFormat::RGBA16F, ImageFormat::R11G11B10F, ImageFormat::RGBA32F }) {
+        OutputImage image;
+        createImage(image, width, height, format);
+        ComputeShader computeShader(ProgramBuilder::compute("computeShader.cs", image.defines()));
+        computeShader.use();
+        FrameStats stats = measure(config, true, [&](int frame) {
+            computeShader.setFloat("t", frame / 60.0f);
+            computeShader.dispatchFor(width, height);
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        });
+        image.release();
+        glDeleteProgram(computeShader.ID);
+        const ImageFormatInfo& info = imageFormatInfo(format);
+        results.push_back({ std::string("gradient_") + info.glsl, width, height, stats, info.bytesPerPixel });
+    }
+    return results;
+}
+
+// computeShader2.cs, igual que test3.cpp; la luz recorre la pantalla
+BenchResult benchLight(const BenchConfig& config, PixelOrder order = PixelOrder::RowMajor) {
+    int width = config.width ? config.width : SCR_WIDTH;
+    int height = config.height ? config.height : SCR_HEIGHT;
+    OutputImage image;
+    createImage(image, width, height, ImageFormat::RGBA8);
+    ComputeShader computeShader(ProgramBuilder::compute("computeShader2.cs", image.defines()));
+    computeShader.use();
+    computeShader.setInt("SCR_WIDTH", width);
+    computeShader.setInt("SCR_HEIGHT", height);
+    computeShader.setFloat("lightIntensity", 5.0f);
+    computeShader.setVec4("baseColor", glm::vec4(0.2f, 0.5f, 0.8f, 1.0f));
+    computeShader.setInt("pixelOrder", (int)order);
+    FrameStats stats = measure(config, true, [&](int frame) {
+        computeShader.setVec2I("lightPos", (frame * 7) % width, height / 2);
+        computeShader.dispatchFor(width, height);
+        glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    });
+    image.release();
+    glDeleteProgram(computeShader.ID);
+    return { "light", width, height, stats };
+}
+
+// La carga "light" presentada con cada PresentMode: la diferencia con "light" es
+// lo que cuesta mostrar el frame (readback lo lleva a la CPU y lo vuelve a subir)
+std::vector<BenchResult> benchPresent(const BenchConfig& config, AppContext& app) {
+    int width = config.width ? config.width : SCR_WIDTH;
+    int height = config.height ? config.height : SCR_HEIGHT;
+    OutputImage image;
+    createImage(image, width, height, ImageFormat::RGBA8);
+    ComputeShader computeShader(ProgramBuilder::compute("computeShader2.cs", image.defines()));
+    std::vector<BenchResult> results;
+    for (PresentMode mode : { PresentMode::Blit, PresentMode::Quad, PresentMode::Readback }) {
+        Presenter presenter;
+        if (!presenter.create(app, mode))
+            continue;
+        computeShader.use();
+        computeShader.setInt("SCR_WIDTH", width);
+        computeShader.setInt("SCR_HEIGHT", height);
+        computeShader.setFloat("lightIntensity", 5.0f);
+        computeShader.setVec4("baseColor", glm::vec4(0.2f, 0.5f, 0.8f, 1.0f));
+        FrameStats stats = measure(config, true, [&](int frame) {
+            // el quad cambia de programa: se vuelve al compute en cada frame
+            computeShader.use();
+            computeShader.setVec2I("lightPos", (frame * 7) % width, height / 2);
+            computeShader.dispatchFor(width, height);
+            glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+            presenter.present(image.texture(), width, height);
+        });
+        presenter.release();
+        results.push_back({ std::string("present_") + Presenter::modeName(mode), width, height, stats });
+    }
+    image.release();
+    glDeleteProgram(computeShader.ID);
+    return results;
+}
+
+// computeSh_test6.cs, igual que test6 con la cámara inicial
+BenchResult benchSpheres(const BenchConfig& config, PixelOrder order = PixelOrder::RowMajor) {
+    int width = config.width ? config.width : SCR_WIDTH;
+    int height = config.height ? config.height : SCR_HEIGHT;
+    OutputImage image;
+    createImage(image, width, height, ImageFormat::RGBA8);
+    ComputeShader computeShader(ProgramBuilder::compute("computeSh_test6.cs", image.defines()));
+    computeShader.use();
+
+    SphereScene scene = benchScene(config);
+    SphereBVH bvh;
+    bvh.build(scene);
+    scene.upload();
+    bvh.upload();
+
+    UniformRing frameParamsRing;
+    frameParamsRing.create(FrameParams::BINDING, sizeof(FrameParams));
+
+    Camera camera(width, height);
+    camera.SetPosition(3.0f, 0.0f, 0.0f);
+    computeShader.setInt("pixelOrder", (int)order);
+
+    FrameStats stats = measure(config, true, [&](int frame) {
+        FrameParams params = {};
+        params.viewMatrix = camera.getView();
+        params.front = camera.getFront();
+        params.up = camera.getUp();
+        params.right = camera.getRight();
+        params.cameraPos = camera.getPosition();
+        params.screenResolution = glm::vec2(width, height);
+        params.iTime = frame / 60.0f;
+        params.FOV = camera.getFov();
+        params.sphereCount = scene.size();
+        params.showGrid = true;
+        params.showAxis = true;
+        frameParamsRing.write(&params);
+        computeShader.dispatchFor(width, height);
+        glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+        frameParamsRing.endFrame();
+    });
+
+    frameParamsRing.release();
+    bvh.release();
+    scene.release();
+    image.release();
+    glDeleteProgram(computeShader.ID);
+    return { "spheres", width, height, stats };
+}
+
+// El trazado de test7: tiles en el pool de hilos y una fila (o un bloque de
+// 8x8 en orden Morton) por paquete de rayos
+BenchResult benchCpuRaytrace(const BenchConfig& config, PixelOrder order = PixelOrder::RowMajor,
+                             PerfCounters* counters = nullptr) {
+    int width = config.width ? config.width : SCR_WIDTH;
+    int height = config.height ? config.height : SCR_HEIGHT;
+    SphereScene scene = benchScene(config);
+    SphereBVH bvh;
+    bvh.build(scene);
+    SphereSceneView spheres = scene.view();
+
+    Camera camera(width, height);
+    camera.SetPosition(3.0f, 0.0f, 0.0f);
+    glm::vec3 ro = camera.getPosition();
+    glm::vec3 front = camera.getFront(), up = camera.getUp(), right = camera.getRight();
+    float fov = camera.getFov() / 90.0f;
+    float aspect = (float)width / (float)height;
+    glm::vec2 resolution(width, height);
+
+    std::vector<uint32_t> pixels(width * height);
+    FrameStats stats = measure(config, false, [&](int) {
+        renderTiles(ThreadPool::global(), width, height, DEFAULT_TILE_SIZE, [&](const Tile& tile) {
+            RayPacket packet;
+            forEachPacket(tile, order, [&](const Tile& block) {
+                int blockWidth = block.x1 - block.x0;
+                packet.reset(blockWidth * (block.y1 - block.y0));
+                for (int y = block.y0; y < block.y1; ++y) {
+                    for (int x = block.x0; x < block.x1; ++x) {
+                        glm::vec2 uv = glm::vec2(x, resolution.y - y) / resolution * 2.0f - 1.0f;
+                        uv.x *= aspect;
+                        packet.setDirection((y - block.y0) * blockWidth + x - block.x0,
+                                            glm::normalize(uv.x * right + uv.y * up + fov * front));
+                    }
+                }
+                bvh.tracePacket(packet, ro, spheres);
+                for (int y = block.y0; y < block.y1; ++y) {
+                    for (int x = block.x0; x < block.x1; ++x) {
+                        glm::vec3 c = glm::clamp(packet.color((y - block.y0) * blockWidth + x - block.x0), 0.0f, 1.0f) * 255.0f;
+                        pixels[y * width + x] = 0xff000000u | ((uint32_t)c.z << 16) | ((uint32_t)c.y << 8) | (uint32_t)c.x;
+                    }
+                }
+            });
+        }, order);
+    }, counters);
+    BenchResult result = { "cpu_raytrace", width, height, stats };
+    if (counters && counters->available()) {
+        result.cacheCounters = true;
+        result.cacheReferences = (double)counters->cacheReferences() / config.frames;
+        result.cacheMisses = (double)counters->cacheMisses() / config.frames;
+    }
+    return result;
+}
+
+// light, spheres y cpu_raytrace por filas y en orden Morton, a 4K salvo --size
+std::vector<BenchResult> benchOrder(const BenchConfig& config, bool gl) {
+    BenchConfig large = config;
+    large.width = config.width ? config.width : ORDER_WIDTH;
+    large.height = config.height ? config.height : ORDER_HEIGHT;
+    // los hilos del pool tienen que existir antes de abrir los contadores
+    ThreadPool::global();
+    PerfCounters counters;
+    if (!counters.create())
+        std::cerr << "perf_event_open no da contadores de caché: solo tiempos" << std::endl;
+
+    std::vector<BenchResult> results;
+    for (PixelOrder order : { PixelOrder::RowMajor, PixelOrder::Morton }) {
+        std::string suffix = std::string("_") + pixelOrderName(order);
+        if (gl) {
+            results.push_back(benchLight(large, order));
+            results.back().name = "order_light" + suffix;
+            results.push_back(benchSpheres(large, order));
+            results.back().name = "order_spheres" + suffix;
+        }
+        results.push_back(benchCpuRaytrace(large, order, &counters));
+        results.back().name = "order_cpu_raytrace" + suffix;
+    }
+    return results;
+}
+
+// Tiempo de crear el ComputeShader hasta que el programa está listo, sin y con la caché
+std::vector<StartupResult> benchStartup() {
+    ProgramCache& cache = ProgramCache::global();
+    std::vector<StartupResult> results;
+    for (const char* path : STARTUP_SHADERS) {
+        StartupResult result;
+        result.shader = path;
+        for (bool cached : { false, true }) {
+            cache.setEnabled(cached);
+            if (cached) {
+                ComputeShader prime(path);    // deja la entrada en disco
+                glDeleteProgram(prime.ID);
+            }
+            for (int i = 0; i < STARTUP_REPEATS; i++) {
+                Clock::time_point start = Clock::now();
+                ComputeShader shader(path);
+                glFinish();
+                double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                (cached ? result.warm : result.cold).add(ms);
+                glDeleteProgram(shader.ID);
+            }
+        }
+        results.push_back(result);
+    }
+    cache.setEnabled(true);
+    return results;
+}
+
+std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+void writeJson(std::ostream& out, const BenchConfig& config, const std::string& renderer,
+               std::vector<BenchResult>& results, std::vector<StartupResult>& startup) {
+    out << std::fixed << std::setprecision(4);
+    out << "{\n";
+    out << "  \"renderer\": " << jsonString(renderer) << ",\n";
+    out << "  \"threads\": " << ThreadPool::global().size() << ",\n";
+    out << "  \"frames\": " << config.frames << ",\n";
+    out << "  \"warmup\": " << config.warmup << ",\n";
+    out << "  \"spheres\": " << config.spheres << ",\n";
+    out << "  \"workloads\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        BenchResult& r = results[i];
+        double pixels = (double)r.width * r.height;
+        out << (i ? "," : "") << "\n    {\n";
+        out << "      \"name\": " << jsonString(r.name) << ",\n";
+        out << "      \"width\": " << r.width << ",\n";
+        out << "      \"height\": " << r.height << ",\n";
+        out << "      \"min_ms\": " << r.stats.min() << ",\n";
+        out << "      \"median_ms\": " << r.stats.median() << ",\n";
+        out << "      \"p99_ms\": " << r.stats.percentile(99.0) << ",\n";
+        out << "      \"mean_ms\": " << r.stats.mean() << ",\n";
+        out << "      \"pixels_per_second\": " << std::setprecision(0) << pixels / (r.stats.median() / 1000.0)
+            << std::setprecision(4) << (r.imageBytesPerPixel || r.cacheCounters ? ",\n" : "\n");
+        if (r.imageBytesPerPixel) {
+            double imageBytes = pixels * r.imageBytesPerPixel;
+            out << "      \"image_bytes_per_pixel\": " << r.imageBytesPerPixel << ",\n";
+            out << "      \"image_mb\": " << imageBytes / (1024.0 * 1024.0) << ",\n";
+            out << "      \"image_write_gb_per_s\": " << imageBytes / (r.stats.median() / 1000.0) / 1.0e9 << "\n";
+        }
+        if (r.cacheCounters) {
+            out << std::setprecision(0);
+            out << "      \"cache_references_per_frame\": " << r.cacheReferences << ",\n";
+            out << "      \"cache_misses_per_frame\": " << r.cacheMisses << ",\n";
+            out << std::setprecision(4);
+            out << "      \"cache_miss_rate\": " << (r.cacheReferences > 0.0 ? r.cacheMisses / r.cacheReferences : 0.0) << "\n";
+        }
+        out << "    }";
+    }
+    out << "\n  ]";
+    if (!startup.empty()) {
+        out << ",\n  \"program_cache\": " << (ProgramCache::global().isEnabled() ? "true" : "false") << ",\n";
+        out << "  \"startup\": [";
+        for (size_t i = 0; i < startup.size(); i++) {
+            StartupResult& r = startup[i];
+            out << (i ? "," : "") << "\n    {\n";
+            out << "      \"shader\": " << jsonString(r.shader) << ",\n";
+            out << "      \"cold_median_ms\": " << r.cold.median() << ",\n";
+            out << "      \"warm_median_ms\": " << r.warm.median() << "\n";
+            out << "    }";
+        }
+        out << "\n  ]";
+    }
+    out << "\n}\n";
+}
+
+int main(int argc, char** argv) {
+    RunOptions options = RunOptions::parse(argc, argv);
+
+    BenchConfig config;
+    config.frames = options.frames;
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            config.warmup = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--spheres") == 0 && i + 1 < argc)
+            config.spheres = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            std::sscanf(argv[++i], "%dx%d", &config.width, &config.height);
+        else
+            names.push_back(argv[i]);
+    }
+    if (names.empty())
+        names = { "gradient", "light", "spheres", "cpu_raytrace", "startup" };
+
+    // sin contexto GL solo se pueden medir las cargas de CPU
+    AppContext app;
+    bool gl = app.create("bench", SCR_WIDTH, SCR_HEIGHT, options);
+    if (!gl) {
+        std::cerr << "Sin contexto OpenGL: solo se miden las cargas de CPU" << std::endl;
+        app.create("bench", SCR_WIDTH, SCR_HEIGHT, options, false);
+    }
+    std::string renderer = gl ? (const char*)glGetString(GL_RENDERER) : "none";
+
+    std::vector<BenchResult> results;
+    std::vector<StartupResult> startup;
+    for (const std::string& name : names) {
+        bool known = name == "gradient" || name == "light" || name == "spheres" || name == "cpu_raytrace"
+            || name == "startup" || name == "formats" || name == "present" || name == "order";
+        if (!known) {
+            std::cerr << "Carga desconocida: " << name << std::endl;
+            continue;
+        }
+        if (!gl && name != "cpu_raytrace" && name != "order")
+            continue;
+        std::cerr << "bench: " << name << std::endl;
+        if (name == "cpu_raytrace")
+            results.push_back(benchCpuRaytrace(config));
+        else if (name == "gradient")
+            results.push_back(benchGradient(config));
+        else if (name == "light")
+            results.push_back(benchLight(config));
+        else if (name == "spheres")
+            results.push_back(benchSpheres(config));
+        else if (name == "startup")
+            startup = benchStartup();
+        else if (name == "formats") {
+            std::vector<BenchResult> formats = benchFormats(config);
+            results.insert(results.end(), formats.begin(), formats.end());
+        }
+        else if (name == "present") {
+            std::vector<BenchResult> present = benchPresent(config, app);
+            results.insert(results.end(), present.begin(), present.end());
+        }
+        else if (name == "order") {
+            std::vector<BenchResult> order = benchOrder(config, gl);
+            results.insert(results.end(), order.begin(), order.end());
+        }
+    }
+
+    if (options.output.empty()) {
+        writeJson(std::cout, config, renderer, results, startup);
+    }
+    else {
+        std::ofstream file(options.output);
+        writeJson(file, config, renderer, results, startup);
+        if (!file)
+            std::cerr << "No se pudo escribir " << options.output << std::endl;
+    }
+
+    app.destroy();
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <glm/glm.hpp>
+#include "sphere_scene.h"
+#include "bvh.h"
+#include "ray_packet.h"
+#include "tile_renderer.h"
+
+// Benchmark de la BVH: tiempo de construcción y rayos/s al crecer la escena.
+// Uso: ./bench_bvh [n1 n2 ...]   (por defecto 1e3 1e4 1e5 1e6 esferas)
+
+const int WIDTH = 800;
+const int HEIGHT = 600;
+const int BUILD_RUNS = 3;
+const int RENDER_RUNS = 5;
+// por encima de esto el recorrido lineal tarda demasiado para medirlo
+const int MAX_LINEAR_SPHERES = 10000;
+// rayos de sombra con los que se compara la BVH con el recorrido lineal
+const int SHADOW_RAYS = 2000;
+const float SHADOW_TOLERANCE = 1e-4f;
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Renderiza un frame con la misma cámara que test7 y devuelve los ms
+double renderFrame(const SphereScene& scene, const SphereBVH* bvh, const glm::vec3& ro,
+                   const glm::vec3& front, const glm::vec3& up, const glm::vec3& right) {
+    SphereSceneView spheres = scene.view();
+    float aspect = (float)WIDTH / (float)HEIGHT;
+    float fov = 45.0f / 90.0f;
+
+    Clock::time_point start = Clock::now();
+    renderTiles(ThreadPool::global(), WIDTH, HEIGHT, DEFAULT_TILE_SIZE, [&](const Tile& tile) {
+        RayPacket packet;
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            packet.reset(tile.x1 - tile.x0);
+            for (int x = tile.x0; x < tile.x1; ++x) {
+                glm::vec2 uv = glm::vec2(x, HEIGHT - y) / glm::vec2(WIDTH, HEIGHT) * 2.0f - 1.0f;
+                uv.x *= aspect;
+                packet.setDirection(x - tile.x0, glm::normalize(uv.x * right + uv.y * up + fov * front));
+            }
+            if (bvh)
+                bvh->tracePacket(packet, ro, spheres);
+            else
+                tracePacket(packet, ro, spheres, 0, spheres.count);
+        }
+    });
+    return msSince(start);
+}
+
+// Mayor diferencia entre la sombra por la BVH y el producto de softShadow
+// sobre todas las esferas, con rayos desde puntos al azar de la escena
+float shadowError(const SphereScene& scene, const SphereBVH& bvh) {
+    SphereSceneView spheres = scene.view();
+    float extent = 4.0f * std::cbrt((float)spheres.count);
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> coord(-extent, extent);
+    std::normal_distribution<float> dir(0.0f, 1.0f);
+
+    float maxError = 0.0f;
+    for (int k = 0; k < SHADOW_RAYS; k++) {
+        glm::vec3 ro(coord(rng), coord(rng), coord(rng));
+        glm::vec3 rd = glm::normalize(glm::vec3(dir(rng), dir(rng), dir(rng)));
+        float linear = 1.0f;
+        for (int i = 0; i < spheres.count; i++)
+            linear *= softShadow(ro, rd, spheres.sphere(i));
+        maxError = std::max(maxError, std::abs(bvh.shadow(ro, rd, spheres) - linear));
+    }
+    return maxError;
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> counts;
+    for (int i = 1; i < argc; i++)
+        counts.push_back(std::atoi(argv[i]));
+    if (counts.empty())
+        counts = { 1000, 10000, 100000, 1000000 };
+
+    std::cout << "threads: " << ThreadPool::global().size() << ", packet kernel: " << rayPacketKernelName()
+              << ", " << WIDTH << "x" << HEIGHT << " rays/frame" << std::endl;
+    std::cout << std::setw(10) << "spheres" << std::setw(8) << "nodes" << std::setw(7) << "depth"
+              << std::setw(12) << "build ms" << std::setw(14) << "BVH Mrays/s" << std::setw(17) << "linear Mrays/s"
+              << std::setw(13) << "shadow diff" << std::endl;
+
+    bool shadowsMatch = true;
+
+    for (int count : counts) {
+        SphereScene scene;
+        SphereBVH bvh;
+        double buildMs = 1e30;
+        for (int run = 0; run < BUILD_RUNS; run++) {
+            // la construcción reordena la escena: cada vuelta parte de la misma
+            scene = SphereScene::random(count);
+            Clock::time_point start = Clock::now();
+            bvh.build(scene);
+            buildMs = std::min(buildMs, msSince(start));
+        }
+
+        // cámara fuera de la caja de la escena mirando hacia su centro (+y)
+        float extent = 4.0f * std::cbrt((float)count);
+        glm::vec3 ro(0.0f, -2.5f * extent, 0.5f * extent);
+        glm::vec3 front(0.0f, 1.0f, 0.0f), up(0.0f, 0.0f, 1.0f), right(1.0f, 0.0f, 0.0f);
+
+        float shadowDiff = count <= MAX_LINEAR_SPHERES ? shadowError(scene, bvh) : -1.0f;
+        shadowsMatch = shadowsMatch && shadowDiff <= SHADOW_TOLERANCE;
+
+        std::vector<double> bvhTimes, linearTimes;
+        for (int run = 0; run < RENDER_RUNS; run++)
+            bvhTimes.push_back(renderFrame(scene, &bvh, ro, front, up, right));
+        if (count <= MAX_LINEAR_SPHERES)
+            for (int run = 0; run < RENDER_RUNS; run++)
+                linearTimes.push_back(renderFrame(scene, nullptr, ro, front, up, right));
+
+        double rays = (double)WIDTH * HEIGHT;
+        std::cout << std::setw(10) << count << std::setw(8) << bvh.nodeCount() << std::setw(7) << bvh.depth()
+                  << std::setw(12) << std::fixed << std::setprecision(2) << buildMs
+                  << std::setw(14) << rays / median(bvhTimes) / 1000.0;
+        if (!linearTimes.empty())
+            std::cout << std::setw(17) << rays / median(linearTimes) / 1000.0;
+        else
+            std::cout << std::setw(17) << "-";
+        if (shadowDiff >= 0.0f)
+            std::cout << std::setw(13) << std::scientific << std::setprecision(1) << shadowDiff;
+        else
+            std::cout << std::setw(13) << "-";
+        std::cout << std::endl;
+    }
+
+    if (!shadowsMatch) {
+        std::cerr << "las sombras por la BVH no coinciden con el recorrido lineal" << std::endl;
+        return 1;
+    }
+    return 0;
+}
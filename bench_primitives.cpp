@@ -0,0 +1,171 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <glad/glad.h>
+#include "app_context.h"
+#include "frame_stats.h"
+#include "compute_primitives.h"
+
+// Benchmark de las primitivas de compute_primitives.h (reducción, scan y
+// histograma) con buffers de 1 MB hasta el tamaño máximo, doblando cada vez.
+// Cada tamaño se comprueba primero contra la referencia de la CPU y luego se
+// mide la mediana de varias ejecuciones (cada una termina con glFinish).
+// GB/s cuenta los bytes leídos y escritos en memoria global por la primitiva.
+// Uso: ./bench_primitives [MB máximos] [repeticiones] [--headless]
+
+const int DEFAULT_MAX_MB = 1024;
+const int DEFAULT_RUNS = 10;
+const int HISTOGRAM_BINS = 256;
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double gbPerSecond(double bytes, double ms) {
+    return bytes / (ms * 1e-3) / 1e9;
+}
+
+GLuint createBuffer(size_t bytes, const void* data) {
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, data, GL_STATIC_DRAW);
+    return buffer;
+}
+
+template <typename T>
+std::vector<T> readBuffer(GLuint buffer, size_t count) {
+    std::vector<T> values(count);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, count * sizeof(T), values.data());
+    return values;
+}
+
+// Mediana en ms de runs ejecuciones de run(), tras una de calentamiento
+template <typename F>
+double medianMs(int runs, F run) {
+    run();
+    glFinish();
+    FrameStats stats;
+    for (int i = 0; i < runs; i++) {
+        Clock::time_point start = Clock::now();
+        run();
+        glFinish();
+        stats.add(msSince(start));
+    }
+    return stats.median();
+}
+
+void printRow(size_t megabytes, const char* name, double bytes, double gpuMs, double cpuMs, bool ok) {
+    std::cout << std::setw(6) << megabytes << std::setw(12) << name
+              << std::setw(12) << gpuMs << std::setw(10) << gbPerSecond(bytes, gpuMs)
+              << std::setw(12) << cpuMs << std::setw(10) << gbPerSecond(bytes, cpuMs)
+              << "  " << (ok ? "ok" : "ERROR") << std::endl;
+}
+
+int main(int argc, char** argv) {
+    RunOptions options = RunOptions::parse(argc, argv);
+    int maxMB = argc > 1 ? std::max(1, std::atoi(argv[1])) : DEFAULT_MAX_MB;
+    int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : DEFAULT_RUNS;
+
+    AppContext app;
+    if (!app.create("bench_primitives", 64, 64, options))
+        return -1;
+
+    GpuReduce reduceSum, reduceMin, reduceMax;
+    GpuScan scan;
+    GpuHistogram histogram;
+    if (!reduceSum.create(ReduceOp::Sum) || !reduceMin.create(ReduceOp::Min) || !reduceMax.create(ReduceOp::Max)
+        || !scan.create() || !histogram.create(HISTOGRAM_BINS)) {
+        std::cerr << "No se pudieron compilar las primitivas" << std::endl;
+        return -1;
+    }
+
+    std::cout << (const char*)glGetString(GL_RENDERER) << ", " << runs << " repeticiones" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(6) << "MB" << std::setw(12) << "primitiva" << std::setw(12) << "GPU ms" << std::setw(10) << "GB/s"
+              << std::setw(12) << "CPU ms" << std::setw(10) << "GB/s" << std::endl;
+
+    std::mt19937 rng(1234);
+    bool allOk = true;
+    for (size_t megabytes = 1; megabytes <= (size_t)maxMB; megabytes *= 2) {
+        size_t count = megabytes * 1024 * 1024 / sizeof(uint32_t);
+        size_t bytes = count * sizeof(uint32_t);
+
+        // reducción: floats en [0, 1), como una luminancia
+        {
+            std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+            std::vector<float> values(count);
+            for (float& v : values)
+                v = dist(rng);
+            GLuint input = createBuffer(bytes, values.data());
+
+            Clock::time_point start = Clock::now();
+            float expected = cpuReduce(values.data(), count, ReduceOp::Sum);
+            double cpuMs = msSince(start);
+            reduceSum.dispatch(input, count);
+            reduceMin.dispatch(input, count);
+            reduceMax.dispatch(input, count);
+            bool ok = std::fabs(reduceSum.read() - expected) <= 1e-4f * expected
+                && reduceMin.read() == cpuReduce(values.data(), count, ReduceOp::Min)
+                && reduceMax.read() == cpuReduce(values.data(), count, ReduceOp::Max);
+            double gpuMs = medianMs(runs, [&]() { reduceSum.dispatch(input, count); });
+            printRow(megabytes, "reduce", (double)bytes, gpuMs, cpuMs, ok);
+            allOk = allOk && ok;
+            glDeleteBuffers(1, &input);
+        }
+
+        std::uniform_int_distribution<uint32_t> dist;
+        std::vector<uint32_t> keys(count);
+        for (uint32_t& k : keys)
+            k = dist(rng);
+        GLuint input = createBuffer(bytes, keys.data());
+
+        // scan: lee la entrada y escribe la salida
+        {
+            GLuint output = createBuffer(bytes, nullptr);
+            std::vector<uint32_t> expected(count);
+            Clock::time_point start = Clock::now();
+            cpuExclusiveScan(keys.data(), expected.data(), count);
+            double cpuMs = msSince(start);
+            scan.dispatch(input, output, count);
+            bool ok = readBuffer<uint32_t>(output, count) == expected;
+            double gpuMs = medianMs(runs, [&]() { scan.dispatch(input, output, count); });
+            printRow(megabytes, "scan", 2.0 * bytes, gpuMs, cpuMs, ok);
+            allOk = allOk && ok;
+            glDeleteBuffers(1, &output);
+        }
+
+        // histograma del byte alto, el del canal alfa en píxeles RGBA8
+        {
+            GLuint bins = createBuffer(HISTOGRAM_BINS * sizeof(uint32_t), nullptr);
+            std::vector<uint32_t> expected(HISTOGRAM_BINS);
+            Clock::time_point start = Clock::now();
+            cpuHistogram(keys.data(), count, expected.data(), HISTOGRAM_BINS, 24);
+            double cpuMs = msSince(start);
+            histogram.dispatch(input, count, bins, 24);
+            bool ok = readBuffer<uint32_t>(bins, HISTOGRAM_BINS) == expected;
+            double gpuMs = medianMs(runs, [&]() { histogram.dispatch(input, count, bins, 24); });
+            printRow(megabytes, "histogram", (double)bytes, gpuMs, cpuMs, ok);
+            allOk = allOk && ok;
+            glDeleteBuffers(1, &bins);
+        }
+
+        glDeleteBuffers(1, &input);
+    }
+
+    reduceSum.release();
+    reduceMin.release();
+    reduceMax.release();
+    scan.release();
+    histogram.release();
+    app.destroy();
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <SDL3/SDL.h>
+#include <glad/glad.h>
+#include "pbo_readback.h"
+#include "app_context.h"
+#include "output_image.h"
+
+// Benchmark del readback: PBOs mapeados en cada frame contra PBOs con mapeo
+// persistente, para varias profundidades del anillo. El consumidor copia el
+// frame a memoria de la CPU, como haría SDL_UpdateTexture o un escritor de archivos.
+// Uso: ./bench_readback [frames] [ancho] [alto] [--headless]
+
+const int WARMUP_FRAMES = 30;
+const int DEPTHS[] = { 1, 2, 3, 4 };
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Result {
+    double frameMs;
+    double stallMs;
+};
+
+// Limpia el framebuffer con un color distinto en cada frame y lo lee con el anillo
+Result run(ReadbackMode mode, int depth, int width, int height, int frames, std::vector<unsigned char>& cpuFrame) {
+    PboReadback readback;
+    readback.create(width, height, depth, GL_RGBA, GL_UNSIGNED_BYTE, mode);
+
+    double totalMs = 0.0;
+    for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+        // la espera media cuenta solo desde que el anillo está lleno y caliente
+        if (frame == WARMUP_FRAMES)
+            readback.resetStallStats();
+        glClearColor((frame % 256) / 255.0f, 0.5f, 0.25f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        Clock::time_point start = Clock::now();
+        readback.readPixels();
+        if (const void* pixels = readback.map()) {
+            std::memcpy(cpuFrame.data(), pixels, readback.frameBytes());
+            readback.unmap();
+        }
+        if (frame >= WARMUP_FRAMES)
+            totalMs += msSince(start);
+    }
+    glFinish();
+
+    Result result = { totalMs / frames, readback.averageStallMs() };
+    readback.release();
+    return result;
+}
+
+int main(int argc, char** argv) {
+    RunOptions options = RunOptions::parse(argc, argv);
+    int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 300;
+    int width = argc > 2 ? std::atoi(argv[2]) : 1920;
+    int height = argc > 3 ? std::atoi(argv[3]) : 1080;
+
+    AppContext app;
+    if (!app.create("bench_readback", 64, 64, options))
+        return -1;
+
+    // framebuffer del tamaño pedido, independiente de la ventana
+    OutputImage image;
+    image.create(width, height, ImageFormat::RGBA8);
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, image.texture(), 0);
+    glViewport(0, 0, width, height);
+
+    std::vector<unsigned char> cpuFrame((size_t)width * height * 4);
+    double frameMB = cpuFrame.size() / (1024.0 * 1024.0);
+
+    std::cout << width << "x" << height << " RGBA8, " << frames << " frames, ARB_buffer_storage: "
+              << (GLAD_GL_ARB_buffer_storage ? "si" : "no") << std::endl;
+    std::cout << std::setw(14) << "mode" << std::setw(7) << "depth" << std::setw(12) << "ms/frame"
+              << std::setw(12) << "stall ms" << std::setw(10) << "MB/s" << std::endl;
+
+    for (ReadbackMode mode : { ReadbackMode::MapPerFrame, ReadbackMode::Persistent }) {
+        if (mode == ReadbackMode::Persistent && !GLAD_GL_ARB_buffer_storage)
+            continue;
+        for (int depth : DEPTHS) {
+            Result result = run(mode, depth, width, height, frames, cpuFrame);
+            std::cout << std::setw(14) << (mode == ReadbackMode::Persistent ? "persistent" : "map/frame")
+                      << std::setw(7) << depth << std::setw(12) << std::fixed << std::setprecision(3) << result.frameMs
+                      << std::setw(12) << result.stallMs << std::setw(10) << std::setprecision(0)
+                      << frameMB / result.frameMs * 1000.0 << std::endl;
+        }
+    }
+
+    glDeleteFramebuffers(1, &framebuffer);
+    image.release();
+    app.destroy();
+    return 0;
+}
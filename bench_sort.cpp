@@ -0,0 +1,144 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <glad/glad.h>
+#include "app_context.h"
+#include "frame_stats.h"
+#include "compute_primitives.h"
+
+// Benchmark del radix sort: GpuRadixSort contra cpuRadixSort (pool de hilos)
+// desde 1M hasta el máximo de claves, doblando cada vez. Claves aleatorias
+// de los bits pedidos (30 como un código Morton 3D) con su índice como valor.
+// El resultado de la GPU se compara con el de la CPU, que a su vez se
+// comprueba con std::is_sorted y los valores.
+// Sin contexto GL solo se mide la CPU, que es la alternativa en ese caso.
+// Uso: ./bench_sort [M claves máximas] [repeticiones] [bits de clave] [--headless]
+
+const int DEFAULT_MAX_MKEYS = 64;
+const int DEFAULT_RUNS = 5;
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+GLuint createBuffer(const std::vector<uint32_t>& data) {
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, data.size() * sizeof(uint32_t), data.data(), GL_DYNAMIC_COPY);
+    return buffer;
+}
+
+std::vector<uint32_t> readBuffer(GLuint buffer, size_t count) {
+    std::vector<uint32_t> values(count);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, count * sizeof(uint32_t), values.data());
+    return values;
+}
+
+// los valores son los índices originales: cada uno tiene que seguir a su clave
+bool validSort(const std::vector<uint32_t>& original, const std::vector<uint32_t>& keys,
+               const std::vector<uint32_t>& values) {
+    if (!std::is_sorted(keys.begin(), keys.end()))
+        return false;
+    for (size_t i = 0; i < keys.size(); i++)
+        if (values[i] >= original.size() || original[values[i]] != keys[i])
+            return false;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    RunOptions options = RunOptions::parse(argc, argv);
+    int maxMKeys = argc > 1 ? std::max(1, std::atoi(argv[1])) : DEFAULT_MAX_MKEYS;
+    int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : DEFAULT_RUNS;
+    int keyBits = argc > 3 ? std::min(32, std::max(1, std::atoi(argv[3]))) : 32;
+    uint32_t mask = keyBits == 32 ? 0xffffffffu : (1u << keyBits) - 1u;
+
+    AppContext app;
+    bool gl = app.create("bench_sort", 64, 64, options);
+    if (!gl) {
+        std::cerr << "Sin contexto OpenGL: solo se mide cpuRadixSort" << std::endl;
+        app.create("bench_sort", 64, 64, options, false);
+    }
+    GpuRadixSort gpuSort;
+    if (gl && !gpuSort.create()) {
+        std::cerr << "No se pudo compilar el radix sort" << std::endl;
+        return -1;
+    }
+
+    std::cout << (gl ? (const char*)glGetString(GL_RENDERER) : "sin GPU") << ", " << ThreadPool::global().size()
+              << " hilos, claves de " << keyBits << " bits, " << runs << " repeticiones" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(8) << "claves" << std::setw(12) << "GPU ms" << std::setw(12) << "Mclaves/s"
+              << std::setw(12) << "CPU ms" << std::setw(12) << "Mclaves/s" << std::endl;
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint32_t> dist;
+    bool allOk = true;
+    for (size_t mkeys = 1; mkeys <= (size_t)maxMKeys; mkeys *= 2) {
+        size_t count = mkeys * 1024 * 1024;
+        std::vector<uint32_t> original(count), indices(count);
+        for (size_t i = 0; i < count; i++) {
+            original[i] = dist(rng) & mask;
+            indices[i] = (uint32_t)i;
+        }
+
+        // CPU: cada repetición parte de los datos sin ordenar
+        std::vector<uint32_t> keys, values;
+        FrameStats cpuStats;
+        for (int run = 0; run < runs; run++) {
+            keys = original;
+            values = indices;
+            Clock::time_point start = Clock::now();
+            cpuRadixSort(keys.data(), values.data(), count, keyBits);
+            cpuStats.add(msSince(start));
+        }
+        bool ok = validSort(original, keys, values);
+        double cpuMs = cpuStats.median();
+
+        double gpuMs = 0.0;
+        if (gl) {
+            GLuint keyBuffer = createBuffer(original);
+            GLuint valueBuffer = createBuffer(indices);
+            gpuSort.sort(keyBuffer, valueBuffer, count, keyBits);
+            // el sort es estable, así que tiene que coincidir con el de la CPU
+            ok = ok && readBuffer(keyBuffer, count) == keys && readBuffer(valueBuffer, count) == values;
+
+            FrameStats gpuStats;
+            for (int run = 0; run < runs; run++) {
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, keyBuffer);
+                glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(uint32_t), original.data());
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, valueBuffer);
+                glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(uint32_t), indices.data());
+                glFinish();
+                Clock::time_point start = Clock::now();
+                gpuSort.sort(keyBuffer, valueBuffer, count, keyBits);
+                glFinish();
+                gpuStats.add(msSince(start));
+            }
+            gpuMs = gpuStats.median();
+            glDeleteBuffers(1, &keyBuffer);
+            glDeleteBuffers(1, &valueBuffer);
+        }
+
+        std::cout << std::setw(7) << mkeys << "M";
+        if (gl)
+            std::cout << std::setw(12) << gpuMs << std::setw(12) << count / (gpuMs * 1e3);
+        else
+            std::cout << std::setw(12) << "-" << std::setw(12) << "-";
+        std::cout << std::setw(12) << cpuMs << std::setw(12) << count / (cpuMs * 1e3)
+                  << "  " << (ok ? "ok" : "ERROR") << std::endl;
+        allOk = allOk && ok;
+    }
+
+    gpuSort.release();
+    app.destroy();
+    return allOk ? 0 : 1;
+}
@@ -1,22 +1,119 @@
 #version 430
-layout(local_size_x = 16, local_size_y = 16) in;
-layout(rgba8, binding = 0) uniform image2D outputImage;
+// WorkgroupTuner antepone los tamaños candidatos como #define
+#ifndef LOCAL_SIZE_X
+#define LOCAL_SIZE_X 16
+#endif
+#ifndef LOCAL_SIZE_Y
+#define LOCAL_SIZE_Y 16
+#endif
+layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y, local_size_z = 1) in;
+// formato de la imagen, elegido por OutputImage::defines()
+#ifndef OUTPUT_FORMAT
+#define OUTPUT_FORMAT rgba8
+#endif
+layout(OUTPUT_FORMAT, binding = 0) uniform image2D outputImage;
+// modo progresivo (ProgressiveState, include/progressive.h): el rayo pasa por
+// coords + sampleJitter, la muestra sampleIndex se suma en accumImage a las
+// anteriores y la salida es la media. Se acumula el color lineal, antes de la
+// gamma; la elipse, los ejes y el área se dibujan encima en cada frame.
+// Con overlayOnly (solo en modo progresivo) la imagen ya convergió: no se
+// traza ni se acumula, se muestra la media de las sampleIndex + 1 muestras y
+// lo de encima, que sigue animándose con iTime
+uniform bool progressive;
+uniform bool overlayOnly;
+uniform int sampleIndex;
+uniform vec2 sampleJitter;
+layout(rgba32f, binding = 1) uniform image2D accumImage;
+// tamaño del problema, de ComputeShader::dispatchFor; los grupos redondeados
+// hacia arriba terminan antes de escribir fuera
+uniform ivec3 dispatchExtent;
+
+// escena en SoA, ver SphereScene (include/sphere_scene.h)
+layout(std430, binding = 1) readonly buffer SphereCenters { vec4 centers[]; };
+layout(std430, binding = 2) readonly buffer SphereRadii { float radii[]; };
+
+// BVH aplanada sobre las esferas, ver SphereBVH (include/bvh.h)
+struct BVHNode
+{
+    vec3 bmin;
+    int  leftFirst;  // nodo interno: hijo izquierdo (el derecho va a continuación); hoja: primera esfera
+    vec3 bmax;
+    int  count;      // 0 en los nodos internos
+};
+layout(std430, binding = 3) readonly buffer BVHNodes { BVHNode nodes[]; };
 
-uniform vec4 sphere; // [x, y, z, radius]
-uniform mat4 viewMatrix;
+const int BVH_STACK_SIZE = 64;
 
-uniform vec3 front;
-uniform vec3 up;
-uniform vec3 right;
-uniform vec3 cameraPos;
+// solo las primeras esferas llevan la elipse/área proyectada encima
+const int MAX_PROJECTED_SPHERES = 16;
 
-uniform vec2 screenResolution;
+// 0: cada invocación en su gl_GlobalInvocationID; 1: Morton (PixelOrder en
+// include/pixel_order.h). Lo mismo que en computeShader2.cs
+uniform int pixelOrder;
 
-uniform float iTime;
-uniform float FOV;
+// bloques de MORTON_BLOCK x MORTON_BLOCK workgroups en curva Z
+const uint MORTON_BLOCK = 8u;
+
+// índice de la curva Z -> (x, y): los bits pares van a x y los impares a y
+uvec2 mortonDecode(uint code) {
+    uvec2 v = uvec2(code, code >> 1u) & 0x55555555u;
+    v = (v | (v >> 1u)) & 0x33333333u;
+    v = (v | (v >> 2u)) & 0x0f0f0f0fu;
+    v = (v | (v >> 4u)) & 0x00ff00ffu;
+    v = (v | (v >> 8u)) & 0x0000ffffu;
+    return v;
+}
 
-uniform bool show_grid;
-uniform bool show_axis;
+// celda que se visita en la posición index de un grid en orden Morton; los
+// bloques cortados por el borde se recorren por filas
+uvec2 mortonCell(uint index, uvec2 grid) {
+    uint band = index / (grid.x * MORTON_BLOCK);
+    uint rows = min(MORTON_BLOCK, grid.y - band * MORTON_BLOCK);
+    uint inBand = index - band * grid.x * MORTON_BLOCK;
+    uint block = inBand / (MORTON_BLOCK * rows);
+    uint cols = min(MORTON_BLOCK, grid.x - block * MORTON_BLOCK);
+    uint inBlock = inBand - block * MORTON_BLOCK * rows;
+    uvec2 cell = (cols == MORTON_BLOCK && rows == MORTON_BLOCK) ? mortonDecode(inBlock) : uvec2(inBlock % cols, inBlock / cols);
+    return uvec2(block, band) * MORTON_BLOCK + cell;
+}
+
+// el workgroup (tile de la imagen) y el píxel que tocan a esta invocación
+uvec2 pixelGroup() {
+    if (pixelOrder == 0)
+        return gl_WorkGroupID.xy;
+    return mortonCell(gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x, gl_NumWorkGroups.xy);
+}
+
+ivec2 pixelCoords(uvec2 group) {
+    if (pixelOrder == 0)
+        return ivec2(gl_GlobalInvocationID.xy);
+    uvec2 size = gl_WorkGroupSize.xy;
+    bool square = size.x == size.y && (size.x & (size.x - 1u)) == 0u;
+    uvec2 local = square ? mortonDecode(gl_LocalInvocationIndex) : gl_LocalInvocationID.xy;
+    return ivec2(group * size + local);
+}
+
+// tileCulling: cada workgroup junta en memoria compartida las esferas que caen
+// en el cono de rayos de su tile y los píxeles prueban solo esas, sin la BVH.
+// Si la lista se llena el tile vuelve a traceSpheres.
+uniform bool tileCulling;
+const int MAX_TILE_SPHERES = 256;
+// holgura angular del cono, cubre el error de acos/asin
+const float TILE_CONE_MARGIN = 0.01;
+shared uint tileSphereCount;
+shared int tileSpheres[MAX_TILE_SPHERES];
+
+// parámetros del frame, se escriben de una vez desde C++ (ver include/frame_params.h)
+layout(std140, binding = 0) uniform FrameParams
+{
+    mat4 viewMatrix;
+    vec3 front;     float iTime;
+    vec3 up;        float FOV;
+    vec3 right;     int   sphereCount;
+    vec3 cameraPos;
+    vec2 screenResolution;
+    bool show_grid; bool  show_axis;
+};
 
 struct ProjectionResult
 {
@@ -107,6 +204,11 @@ float PrintInt(const in vec2 uv, const in float value )
     return res;	
 }
 
+vec4 getSphere( in int i )
+{
+    return vec4( centers[i].xyz, radii[i] );
+}
+
 float iSphere( in vec3 ro, in vec3 rd, in vec4 sph )
 {
     vec3 oc = ro - sph.xyz;
@@ -131,6 +233,133 @@ float ssSphere( in vec3 ro, in vec3 rd, in vec4 sph )
     return res;
 }
 
+// distancia de entrada a la caja, 1e30 si el rayo no la cruza
+float iBox( in vec3 ro, in vec3 ird, in vec3 bmin, in vec3 bmax )
+{
+    vec3 t0 = (bmin-ro)*ird;
+    vec3 t1 = (bmax-ro)*ird;
+    vec3 tn = min( t0, t1 );
+    vec3 tf = max( t0, t1 );
+    float tnear = max( max( tn.x, tn.y ), tn.z );
+    float tfar  = min( min( tf.x, tf.y ), tf.z );
+    return (tfar >= max( tnear, 0.0 )) ? max( tnear, 0.0 ) : 1e30;
+}
+
+// recorre la BVH y devuelve el índice de la esfera más cercana (o -1), acortando tmin
+int traceSpheres( in vec3 ro, in vec3 rd, inout float tmin )
+{
+    int hit = -1;
+    if( sphereCount==0 ) return hit;
+
+    vec3 ird = 1.0/rd;
+    int stack[BVH_STACK_SIZE];
+    int sp = 0;
+    stack[sp++] = 0;
+
+    while( sp>0 )
+    {
+        BVHNode node = nodes[stack[--sp]];
+        if( iBox( ro, ird, node.bmin, node.bmax )>=tmin ) continue;
+
+        if( node.count>0 )
+        {
+            for( int i=node.leftFirst; i<node.leftFirst+node.count; i++ )
+            {
+                float h = iSphere( ro, rd, getSphere( i ) );
+                if( h>0.0 && h<tmin ) { tmin = h; hit = i; }
+            }
+        }
+        else
+        {
+            // el hijo más cercano se apila al final para visitarlo primero
+            int l = node.leftFirst;
+            float tl = iBox( ro, ird, nodes[l].bmin, nodes[l].bmax );
+            float tr = iBox( ro, ird, nodes[l+1].bmin, nodes[l+1].bmax );
+            int nearChild = (tl<=tr) ? l : l+1;
+            int farChild  = (tl<=tr) ? l+1 : l;
+            if( max( tl, tr )<tmin ) stack[sp++] = farChild;
+            if( min( tl, tr )<tmin ) stack[sp++] = nearChild;
+        }
+    }
+    return hit;
+}
+
+// ssSphere oscurece todo rayo que pase a distancia d del centro con
+// d^2 < r^2 + b/12, siendo b la distancia a lo largo del rayo hasta el punto
+// más cercano al centro: la penumbra crece con b. Como la esfera entera cabe
+// en la caja del nodo, basta agrandar la caja sqrt(b/12), con b acotada por la
+// esquina más lejana en la dirección del rayo. Devuelve -1 si todo el nodo
+// queda detrás del origen (b<=0, ssSphere da 1). Copia de shadowMargin() en
+// include/bvh.h
+float shadowMargin( in BVHNode node, in vec3 ro, in vec3 rd )
+{
+    vec3 corner = mix( node.bmin, node.bmax, step( 0.0, rd ) );
+    float b = dot( corner-ro, rd );
+    return (b>0.0) ? sqrt( b/12.0 ) : -1.0;
+}
+
+// producto de las sombras suaves de las esferas cercanas al rayo de sombra;
+// da lo mismo que recorrer todas las esferas, ver shadowMargin()
+float shadowSpheres( in vec3 ro, in vec3 rd )
+{
+    float sha = 1.0;
+    if( sphereCount==0 ) return sha;
+
+    vec3 ird = 1.0/rd;
+    int stack[BVH_STACK_SIZE];
+    int sp = 0;
+    stack[sp++] = 0;
+
+    while( sp>0 )
+    {
+        BVHNode node = nodes[stack[--sp]];
+        float margin = shadowMargin( node, ro, rd );
+        if( margin<0.0 || iBox( ro, ird, node.bmin-margin, node.bmax+margin )>=1e30 ) continue;
+
+        if( node.count>0 )
+        {
+            for( int i=node.leftFirst; i<node.leftFirst+node.count; i++ )
+                sha *= ssSphere( ro, rd, getSphere( i ) );
+        }
+        else
+        {
+            stack[sp++] = node.leftFirst;
+            stack[sp++] = node.leftFirst+1;
+        }
+    }
+    return sha;
+}
+
+// dirección del rayo del píxel coords, la misma que calcula main()
+vec3 rayDirection( in vec2 coords )
+{
+    vec2 uv = coords / screenResolution * 2.0 - 1.0;
+    return normalize( uv.x * right + uv.y * up + FOV/90.0 * front );
+}
+
+// la esfera puede cortar algún rayo del cono (eje axis, semiángulo angle)
+bool sphereInCone( in vec4 sph, in vec3 ro, in vec3 axis, in float angle )
+{
+    vec3 oc = sph.xyz - ro;
+    float dist = length( oc );
+    if( dist<=sph.w ) return true;
+    float toCenter = acos( clamp( dot( oc, axis )/dist, -1.0, 1.0 ) );
+    return toCenter <= angle + asin( sph.w/dist ) + TILE_CONE_MARGIN;
+}
+
+// traceSpheres sobre la lista del tile en lugar de la BVH
+int traceTileSpheres( in vec3 ro, in vec3 rd, inout float tmin )
+{
+    int hit = -1;
+    for( uint k=0u; k<tileSphereCount; k++ )
+    {
+        int i = tileSpheres[k];
+        float h = iSphere( ro, rd, getSphere( i ) );
+        if( h>0.0 && (h<tmin || (h==tmin && i<hit)) ) { tmin = h; hit = i; }
+    }
+    return hit;
+}
+
 float sdSegment( vec2 p, vec2 a, vec2 b )
 {
     vec2 pa = p - a;
@@ -162,39 +391,25 @@ float gridTextureGradBox( in vec2 p, in vec2 x, in vec2 y )
     return (1.0-i.x)*(1.0-i.y);
 }
 
-void main() {
-    ivec2 coords = ivec2(gl_GlobalInvocationID.xy);
-
-    // Normalizar las coordenadas de la textura a [-1, 1]
-    vec2 uv = vec2(coords) / screenResolution * 2.0 - 1.0;
-
-    float fov = FOV/90.0;
-
-    vec3 ro = cameraPos;
-    vec3 rd = normalize( uv.x * right + uv.y * up + fov * front );
-
-    const vec4 sph[3] = vec4[3]( vec4(-2.0, 1.0,0.0,1.1),
-                                vec4( 3.0, 1.5,1.0,1.2),
-                                vec4( 1.0,-1.0,1.0,1.3) );
-
+// color lineal del rayo (ro, rd), antes de la gamma y de lo que va encima
+vec3 render( in vec3 ro, in vec3 rd )
+{
     float tmin = 10000.0;
     vec3  nor = vec3(0.0);
     vec3  pos = vec3(0.0);
 
     vec3 sur = vec3(1.0);
 
-    for( int i=0; i<3; i++ )
-    {
-        float h = iSphere( ro, rd, sph[i] );
-        if( h>0.0 && h<tmin ) 
-        { 
-            tmin = h; 
-            pos = ro + h*rd;
-            nor = normalize(pos-sph[i].xyz); 
-            sur = 0.5 + 0.5*cos(float(i)*2.0+vec3(0.0,2.0,4.0));              
-            sur *= 0.4;
-            sur *= smoothstep(-0.6,-0.2,sin(20.0*(pos.x-sph[i].x)));
-        }
+    int id = (tileCulling && tileSphereCount<=uint(MAX_TILE_SPHERES))
+        ? traceTileSpheres( ro, rd, tmin ) : traceSpheres( ro, rd, tmin );
+    if( id>=0 ) 
+    { 
+        vec4 sph = getSphere( id );
+        pos = ro + tmin*rd;
+        nor = normalize(pos-sph.xyz); 
+        sur = 0.5 + 0.5*cos(float(id)*2.0+vec3(0.0,2.0,4.0));              
+        sur *= 0.4;
+        sur *= smoothstep(-0.6,-0.2,sin(20.0*(pos.x-sph.x)));
     }
 
     float h = (-2.0-ro.z)/rd.z;
@@ -214,11 +429,7 @@ void main() {
         col = vec3(1.0);
         
         vec3 lig = normalize( vec3(2.0,1.4,-1.0) );
-        float sha = 1.0;
-        for( int i=0; i<3; i++ )
-        {
-            sha *= ssSphere( pos, lig, sph[i] );
-        }
+        float sha = shadowSpheres( pos, lig );
 
         float ndl = clamp( dot(nor,lig), 0.0, 1.0 );
         col = (0.5+0.5*nor.y)*vec3(0.2,0.3,0.4) + sha*vec3(1.0,0.9,0.8)*ndl + sha*vec3(1.5)*ndl*pow( clamp(dot(normalize(-rd+lig),nor),0.0,1.0), 16.0 );
@@ -228,12 +439,85 @@ void main() {
 
     }
 
+    return col;
+}
+
+void main() {
+    uvec2 group = pixelGroup();
+    ivec2 coords = pixelCoords(group);
+
+    // lista de esferas del tile; barrier() no puede ir tras un return ni
+    // dentro de un if, así que va antes de descartar las invocaciones de fuera
+    if (gl_LocalInvocationIndex == 0u)
+        tileSphereCount = 0u;
+    memoryBarrierShared();
+    barrier();
+    if (tileCulling && !(progressive && overlayOnly))
+    {
+        // cono desde el rayo central del tile hasta sus esquinas; en modo
+        // progresivo el jitter mueve los rayos hasta un píxel más allá
+        vec2 tileMin = vec2(group * gl_WorkGroupSize.xy);
+        vec2 tileMax = tileMin + vec2(gl_WorkGroupSize.xy) - (progressive ? 0.0 : 1.0);
+        vec3 axis = rayDirection( 0.5*(tileMin + tileMax) );
+        float angle = 0.0;
+        angle = max( angle, acos( clamp( dot( axis, rayDirection( tileMin ) ), -1.0, 1.0 ) ) );
+        angle = max( angle, acos( clamp( dot( axis, rayDirection( vec2(tileMax.x, tileMin.y) ) ), -1.0, 1.0 ) ) );
+        angle = max( angle, acos( clamp( dot( axis, rayDirection( vec2(tileMin.x, tileMax.y) ) ), -1.0, 1.0 ) ) );
+        angle = max( angle, acos( clamp( dot( axis, rayDirection( tileMax ) ), -1.0, 1.0 ) ) );
+
+        int groupInvocations = int(gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z);
+        for( int i=int(gl_LocalInvocationIndex); i<sphereCount; i+=groupInvocations )
+        {
+            if( sphereInCone( getSphere( i ), cameraPos, axis, angle ) )
+            {
+                uint slot = atomicAdd( tileSphereCount, 1u );
+                if( slot<uint(MAX_TILE_SPHERES) ) tileSpheres[slot] = i;
+            }
+        }
+    }
+    memoryBarrierShared();
+    barrier();
+
+    if (any(greaterThanEqual(coords, dispatchExtent.xy)))
+        return;
+
+    // Normalizar las coordenadas de la textura a [-1, 1]
+    vec2 uv = vec2(coords) / screenResolution * 2.0 - 1.0;
+    // el rayo se desplaza dentro del píxel en el modo progresivo; lo que se
+    // dibuja encima sigue en uv para que no tiemble. Sumado a uv, el jitter 0
+    // de la muestra 0 da exactamente el rayo de siempre
+    vec2 rayUv = progressive ? uv + sampleJitter * 2.0 / screenResolution : uv;
+
+    float fov = FOV/90.0;
+
+    vec3 ro = cameraPos;
+    vec3 rd = normalize( rayUv.x * right + rayUv.y * up + fov * front );
+
+    vec3 col = (progressive && overlayOnly) ? vec3(0.0) : render( ro, rd );
+
+    if (progressive)
+    {
+        vec3 sum = col;
+        if (overlayOnly)
+            sum = imageLoad(accumImage, coords).rgb;
+        else
+        {
+            if (sampleIndex > 0)
+                sum += imageLoad(accumImage, coords).rgb;
+            imageStore(accumImage, coords, vec4(sum, 1.0));
+        }
+        // la muestra 0 queda tal cual: hay drivers que dividen con un
+        // recíproco aproximado y x / 1.0 no da x
+        if (sampleIndex > 0)
+            col = sum / float(sampleIndex + 1);
+    }
+
     col = pow( col, vec3(0.45) );
 
     //-------------------------------------------------------
-    for( int i=0; i<3; i++ )
+    for( int i=0; i<min(sphereCount, MAX_PROJECTED_SPHERES); i++ )
     {
-        ProjectionResult res = projectSphere( sph[i], viewMatrix, fov );
+        ProjectionResult res = projectSphere( getSphere( i ), viewMatrix, fov );
         res.area *= screenResolution.y*screenResolution.y*0.25;
         if( res.area>0.0 )
         {
@@ -1,6 +1,13 @@
 #version 430 core
 
-layout (local_size_x = 10, local_size_y = 10, local_size_z = 1) in;
+// WorkgroupTuner prepends candidate sizes as #defines
+#ifndef LOCAL_SIZE_X
+#define LOCAL_SIZE_X 10
+#endif
+#ifndef LOCAL_SIZE_Y
+#define LOCAL_SIZE_Y 10
+#endif
+layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y, local_size_z = 1) in;
 
 // ----------------------------------------------------------------------------
 //
@@ -8,9 +15,14 @@ layout (local_size_x = 10, local_size_y = 10, local_size_z = 1) in;
 //
 // ----------------------------------------------------------------------------
 
-layout(rgba32f, binding = 0) uniform image2D imgOutput;
+// image format, picked per kernel by OutputImage::defines(); two 0..1 channels fit in 8 bits
+#ifndef OUTPUT_FORMAT
+#define OUTPUT_FORMAT rgba8
+#endif
+layout(OUTPUT_FORMAT, binding = 0) uniform image2D imgOutput;
 
 layout (location = 0) uniform float t;                 /** Time */
+uniform ivec3 dispatchExtent;                          /** Problem size, from ComputeShader::dispatchFor */
 
 // ----------------------------------------------------------------------------
 //
@@ -21,11 +33,14 @@ layout (location = 0) uniform float t;                 /** Time */
 void main() {
 	vec4 value = vec4(0.0, 0.0, 0.0, 1.0);
 	ivec2 texelCoord = ivec2(gl_GlobalInvocationID.xy);
+	// workgroups are rounded up; the extra invocations must not write
+	if (any(greaterThanEqual(texelCoord, dispatchExtent.xy)))
+		return;
 	float speed = 100;
 	// the width of the texture
-	float width = 1000;
+	float width = float(dispatchExtent.x);
 
-	value.x = mod(float(texelCoord.x) + t * speed, width) / (gl_NumWorkGroups.x * gl_WorkGroupSize.x);
-	value.y = float(texelCoord.y)/(gl_NumWorkGroups.y*gl_WorkGroupSize.y);
+	value.x = mod(float(texelCoord.x) + t * speed, width) / width;
+	value.y = float(texelCoord.y) / float(dispatchExtent.y);
 	imageStore(imgOutput, texelCoord, value);
 }
\ No newline at end of file
@@ -1,14 +1,75 @@
 #version 430
-layout(local_size_x = 16, local_size_y = 16) in;
-layout(rgba8, binding = 0) uniform image2D outputImage;
+// WorkgroupTuner antepone los tamaños candidatos como #define
+#ifndef LOCAL_SIZE_X
+#define LOCAL_SIZE_X 16
+#endif
+#ifndef LOCAL_SIZE_Y
+#define LOCAL_SIZE_Y 16
+#endif
+layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y, local_size_z = 1) in;
+// formato de la imagen, elegido por OutputImage::defines()
+#ifndef OUTPUT_FORMAT
+#define OUTPUT_FORMAT rgba8
+#endif
+layout(OUTPUT_FORMAT, binding = 0) uniform image2D outputImage;
 
+// tamaño del problema, de ComputeShader::dispatchFor; los grupos redondeados
+// hacia arriba terminan antes de escribir fuera
+uniform ivec3 dispatchExtent;
 uniform int SCR_WIDTH, SCR_HEIGHT;
 uniform ivec2 lightPos; // Posición de la luz en coordenadas de textura
 uniform float lightIntensity; // Intensidad de la luz
 uniform vec4 baseColor; // Color base de la textura
+// 0: cada invocación en su gl_GlobalInvocationID; 1: Morton (PixelOrder en
+// include/pixel_order.h). Igual en computeSh_test6.cs
+uniform int pixelOrder;
+
+// bloques de MORTON_BLOCK x MORTON_BLOCK workgroups en curva Z
+const uint MORTON_BLOCK = 8u;
+
+// índice de la curva Z -> (x, y): los bits pares van a x y los impares a y
+uvec2 mortonDecode(uint code) {
+    uvec2 v = uvec2(code, code >> 1u) & 0x55555555u;
+    v = (v | (v >> 1u)) & 0x33333333u;
+    v = (v | (v >> 2u)) & 0x0f0f0f0fu;
+    v = (v | (v >> 4u)) & 0x00ff00ffu;
+    v = (v | (v >> 8u)) & 0x0000ffffu;
+    return v;
+}
+
+// celda que se visita en la posición index de un grid en orden Morton; los
+// bloques cortados por el borde se recorren por filas
+uvec2 mortonCell(uint index, uvec2 grid) {
+    uint band = index / (grid.x * MORTON_BLOCK);
+    uint rows = min(MORTON_BLOCK, grid.y - band * MORTON_BLOCK);
+    uint inBand = index - band * grid.x * MORTON_BLOCK;
+    uint block = inBand / (MORTON_BLOCK * rows);
+    uint cols = min(MORTON_BLOCK, grid.x - block * MORTON_BLOCK);
+    uint inBlock = inBand - block * MORTON_BLOCK * rows;
+    uvec2 cell = (cols == MORTON_BLOCK && rows == MORTON_BLOCK) ? mortonDecode(inBlock) : uvec2(inBlock % cols, inBlock / cols);
+    return uvec2(block, band) * MORTON_BLOCK + cell;
+}
+
+// el workgroup (tile de la imagen) y el píxel que tocan a esta invocación
+uvec2 pixelGroup() {
+    if (pixelOrder == 0)
+        return gl_WorkGroupID.xy;
+    return mortonCell(gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x, gl_NumWorkGroups.xy);
+}
+
+ivec2 pixelCoords(uvec2 group) {
+    if (pixelOrder == 0)
+        return ivec2(gl_GlobalInvocationID.xy);
+    uvec2 size = gl_WorkGroupSize.xy;
+    bool square = size.x == size.y && (size.x & (size.x - 1u)) == 0u;
+    uvec2 local = square ? mortonDecode(gl_LocalInvocationIndex) : gl_LocalInvocationID.xy;
+    return ivec2(group * size + local);
+}
 
 void main() {
-    ivec2 coords = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 coords = pixelCoords(pixelGroup());
+    if (any(greaterThanEqual(coords, dispatchExtent.xy)))
+        return;
 
     // Calcular la distancia del píxel a la fuente de luz
     float dist = length(vec2(coords - lightPos));
@@ -7,6 +7,7 @@
     APIs: gl=4.3
     Profile: core
     Extensions:
+        GL_ARB_buffer_storage,
         GL_ARB_compute_shader,
         GL_ARB_compute_variable_group_size,
         GL_ARB_direct_state_access,
@@ -16,16 +17,17 @@
         GL_ARB_shader_storage_buffer_object,
         GL_ARB_texture_storage,
         GL_ARB_uniform_buffer_object,
-        GL_ARB_vertex_attrib_binding
+        GL_ARB_vertex_attrib_binding,
+        GL_KHR_parallel_shader_compile
     Loader: True
     Local files: True
     Omit khrplatform: False
     Reproducible: False
 
     Commandline:
-        --profile="core" --api="gl=4.3" --generator="c" --spec="gl" --local-files --extensions="GL_ARB_compute_shader,GL_ARB_compute_variable_group_size,GL_ARB_direct_state_access,GL_ARB_framebuffer_object,GL_ARB_program_interface_query,GL_ARB_shader_image_load_store,GL_ARB_shader_storage_buffer_object,GL_ARB_texture_storage,GL_ARB_uniform_buffer_object,GL_ARB_vertex_attrib_binding"
+        --profile="core" --api="gl=4.3" --generator="c" --spec="gl" --local-files --extensions="GL_ARB_buffer_storage,GL_ARB_compute_shader,GL_ARB_compute_variable_group_size,GL_ARB_direct_state_access,GL_ARB_framebuffer_object,GL_ARB_program_interface_query,GL_ARB_shader_image_load_store,GL_ARB_shader_storage_buffer_object,GL_ARB_texture_storage,GL_ARB_uniform_buffer_object,GL_ARB_vertex_attrib_binding,GL_KHR_parallel_shader_compile"
     Online:
-        https://glad.dav1d.de/#profile=core&language=c&specification=gl&loader=on&api=gl%3D4.3&extensions=GL_ARB_compute_shader&extensions=GL_ARB_compute_variable_group_size&extensions=GL_ARB_direct_state_access&extensions=GL_ARB_framebuffer_object&extensions=GL_ARB_program_interface_query&extensions=GL_ARB_shader_image_load_store&extensions=GL_ARB_shader_storage_buffer_object&extensions=GL_ARB_texture_storage&extensions=GL_ARB_uniform_buffer_object&extensions=GL_ARB_vertex_attrib_binding
+        https://glad.dav1d.de/#profile=core&language=c&specification=gl&loader=on&api=gl%3D4.3&extensions=GL_ARB_buffer_storage&extensions=GL_ARB_compute_shader&extensions=GL_ARB_compute_variable_group_size&extensions=GL_ARB_direct_state_access&extensions=GL_ARB_framebuffer_object&extensions=GL_ARB_program_interface_query&extensions=GL_ARB_shader_image_load_store&extensions=GL_ARB_shader_storage_buffer_object&extensions=GL_ARB_texture_storage&extensions=GL_ARB_uniform_buffer_object&extensions=GL_ARB_vertex_attrib_binding&extensions=GL_KHR_parallel_shader_compile
 */
 
 
@@ -3203,6 +3205,15 @@ typedef void (APIENTRYP PFNGLGETPOINTERVPROC)(GLenum pname, void **params);
 GLAPI PFNGLGETPOINTERVPROC glad_glGetPointerv;
 #define glGetPointerv glad_glGetPointerv
 #endif
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#define GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT 0x00004000
+#define GL_BUFFER_IMMUTABLE_STORAGE 0x821F
+#define GL_BUFFER_STORAGE_FLAGS 0x8220
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
 #define GL_MAX_COMPUTE_VARIABLE_GROUP_INVOCATIONS_ARB 0x9344
 #define GL_MAX_COMPUTE_FIXED_GROUP_INVOCATIONS_ARB 0x90EB
 #define GL_MAX_COMPUTE_VARIABLE_GROUP_SIZE_ARB 0x9345
@@ -3210,6 +3221,13 @@ GLAPI PFNGLGETPOINTERVPROC glad_glGetPointerv;
 #define GL_TEXTURE_TARGET 0x1006
 #define GL_QUERY_TARGET 0x82EA
 #define GL_INDEX 0x8222
+#ifndef GL_ARB_buffer_storage
+#define GL_ARB_buffer_storage 1
+GLAPI int GLAD_GL_ARB_buffer_storage;
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+GLAPI PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+#define glBufferStorage glad_glBufferStorage
+#endif
 #ifndef GL_ARB_compute_shader
 #define GL_ARB_compute_shader 1
 GLAPI int GLAD_GL_ARB_compute_shader;
@@ -3544,6 +3562,13 @@ GLAPI int GLAD_GL_ARB_uniform_buffer_object;
 #define GL_ARB_vertex_attrib_binding 1
 GLAPI int GLAD_GL_ARB_vertex_attrib_binding;
 #endif
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_KHR_parallel_shader_compile 1
+GLAPI int GLAD_GL_KHR_parallel_shader_compile;
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+GLAPI PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glad_glMaxShaderCompilerThreadsKHR
+#endif
 
 #ifdef __cplusplus
 }
@@ -7,6 +7,7 @@
     APIs: gl=4.3
     Profile: core
     Extensions:
+        GL_ARB_buffer_storage,
         GL_ARB_compute_shader,
         GL_ARB_compute_variable_group_size,
         GL_ARB_direct_state_access,
@@ -16,16 +17,17 @@
         GL_ARB_shader_storage_buffer_object,
         GL_ARB_texture_storage,
         GL_ARB_uniform_buffer_object,
-        GL_ARB_vertex_attrib_binding
+        GL_ARB_vertex_attrib_binding,
+        GL_KHR_parallel_shader_compile
     Loader: True
     Local files: True
     Omit khrplatform: False
     Reproducible: False
 
     Commandline:
-        --profile="core" --api="gl=4.3" --generator="c" --spec="gl" --local-files --extensions="GL_ARB_compute_shader,GL_ARB_compute_variable_group_size,GL_ARB_direct_state_access,GL_ARB_framebuffer_object,GL_ARB_program_interface_query,GL_ARB_shader_image_load_store,GL_ARB_shader_storage_buffer_object,GL_ARB_texture_storage,GL_ARB_uniform_buffer_object,GL_ARB_vertex_attrib_binding"
+        --profile="core" --api="gl=4.3" --generator="c" --spec="gl" --local-files --extensions="GL_ARB_buffer_storage,GL_ARB_compute_shader,GL_ARB_compute_variable_group_size,GL_ARB_direct_state_access,GL_ARB_framebuffer_object,GL_ARB_program_interface_query,GL_ARB_shader_image_load_store,GL_ARB_shader_storage_buffer_object,GL_ARB_texture_storage,GL_ARB_uniform_buffer_object,GL_ARB_vertex_attrib_binding,GL_KHR_parallel_shader_compile"
     Online:
-        https://glad.dav1d.de/#profile=core&language=c&specification=gl&loader=on&api=gl%3D4.3&extensions=GL_ARB_compute_shader&extensions=GL_ARB_compute_variable_group_size&extensions=GL_ARB_direct_state_access&extensions=GL_ARB_framebuffer_object&extensions=GL_ARB_program_interface_query&extensions=GL_ARB_shader_image_load_store&extensions=GL_ARB_shader_storage_buffer_object&extensions=GL_ARB_texture_storage&extensions=GL_ARB_uniform_buffer_object&extensions=GL_ARB_vertex_attrib_binding
+        https://glad.dav1d.de/#profile=core&language=c&specification=gl&loader=on&api=gl%3D4.3&extensions=GL_ARB_buffer_storage&extensions=GL_ARB_compute_shader&extensions=GL_ARB_compute_variable_group_size&extensions=GL_ARB_direct_state_access&extensions=GL_ARB_framebuffer_object&extensions=GL_ARB_program_interface_query&extensions=GL_ARB_shader_image_load_store&extensions=GL_ARB_shader_storage_buffer_object&extensions=GL_ARB_texture_storage&extensions=GL_ARB_uniform_buffer_object&extensions=GL_ARB_vertex_attrib_binding&extensions=GL_KHR_parallel_shader_compile
 */
 
 #include <stdio.h>
@@ -844,6 +846,7 @@ PFNGLVIEWPORTARRAYVPROC glad_glViewportArrayv = NULL;
 PFNGLVIEWPORTINDEXEDFPROC glad_glViewportIndexedf = NULL;
 PFNGLVIEWPORTINDEXEDFVPROC glad_glViewportIndexedfv = NULL;
 PFNGLWAITSYNCPROC glad_glWaitSync = NULL;
+int GLAD_GL_ARB_buffer_storage = 0;
 int GLAD_GL_ARB_compute_shader = 0;
 int GLAD_GL_ARB_compute_variable_group_size = 0;
 int GLAD_GL_ARB_direct_state_access = 0;
@@ -854,6 +857,9 @@ int GLAD_GL_ARB_shader_storage_buffer_object = 0;
 int GLAD_GL_ARB_texture_storage = 0;
 int GLAD_GL_ARB_uniform_buffer_object = 0;
 int GLAD_GL_ARB_vertex_attrib_binding = 0;
+int GLAD_GL_KHR_parallel_shader_compile = 0;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR = NULL;
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = NULL;
 PFNGLDISPATCHCOMPUTEGROUPSIZEARBPROC glad_glDispatchComputeGroupSizeARB = NULL;
 PFNGLCREATETRANSFORMFEEDBACKSPROC glad_glCreateTransformFeedbacks = NULL;
 PFNGLTRANSFORMFEEDBACKBUFFERBASEPROC glad_glTransformFeedbackBufferBase = NULL;
@@ -1568,6 +1574,10 @@ static void load_GL_VERSION_4_3(GLADloadproc load) {
 	glad_glGetObjectPtrLabel = (PFNGLGETOBJECTPTRLABELPROC)load("glGetObjectPtrLabel");
 	glad_glGetPointerv = (PFNGLGETPOINTERVPROC)load("glGetPointerv");
 }
+static void load_GL_ARB_buffer_storage(GLADloadproc load) {
+	if(!GLAD_GL_ARB_buffer_storage) return;
+	glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+}
 static void load_GL_ARB_compute_shader(GLADloadproc load) {
 	if(!GLAD_GL_ARB_compute_shader) return;
 	glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
@@ -1746,8 +1756,13 @@ static void load_GL_ARB_vertex_attrib_binding(GLADloadproc load) {
 	glad_glVertexAttribBinding = (PFNGLVERTEXATTRIBBINDINGPROC)load("glVertexAttribBinding");
 	glad_glVertexBindingDivisor = (PFNGLVERTEXBINDINGDIVISORPROC)load("glVertexBindingDivisor");
 }
+static void load_GL_KHR_parallel_shader_compile(GLADloadproc load) {
+	if(!GLAD_GL_KHR_parallel_shader_compile) return;
+	glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+}
 static int find_extensionsGL(void) {
 	if (!get_exts()) return 0;
+	GLAD_GL_ARB_buffer_storage = has_ext("GL_ARB_buffer_storage");
 	GLAD_GL_ARB_compute_shader = has_ext("GL_ARB_compute_shader");
 	GLAD_GL_ARB_compute_variable_group_size = has_ext("GL_ARB_compute_variable_group_size");
 	GLAD_GL_ARB_direct_state_access = has_ext("GL_ARB_direct_state_access");
@@ -1758,6 +1773,7 @@ static int find_extensionsGL(void) {
 	GLAD_GL_ARB_texture_storage = has_ext("GL_ARB_texture_storage");
 	GLAD_GL_ARB_uniform_buffer_object = has_ext("GL_ARB_uniform_buffer_object");
 	GLAD_GL_ARB_vertex_attrib_binding = has_ext("GL_ARB_vertex_attrib_binding");
+	GLAD_GL_KHR_parallel_shader_compile = has_ext("GL_KHR_parallel_shader_compile");
 	free_exts();
 	return 1;
 }
@@ -1844,6 +1860,7 @@ int gladLoadGLLoader(GLADloadproc load) {
 	load_GL_VERSION_4_3(load);
 
 	if (!find_extensionsGL()) return 0;
+	load_GL_ARB_buffer_storage(load);
 	load_GL_ARB_compute_shader(load);
 	load_GL_ARB_compute_variable_group_size(load);
 	load_GL_ARB_direct_state_access(load);
@@ -1854,6 +1871,7 @@ int gladLoadGLLoader(GLADloadproc load) {
 	load_GL_ARB_texture_storage(load);
 	load_GL_ARB_uniform_buffer_object(load);
 	load_GL_ARB_vertex_attrib_binding(load);
+	load_GL_KHR_parallel_shader_compile(load);
 	return GLVersion.major != 0 || GLVersion.minor != 0;
 }
 
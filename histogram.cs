@@ -0,0 +1,57 @@
+#version 430
+// Histograma de un buffer de uints: cada clave cae en el bin
+// (clave >> shift) & (NUM_BINS - 1). Con píxeles RGBA8 empaquetados y shift
+// 0/8/16/24 da el histograma de cada canal. Cada workgroup cuenta en memoria
+// compartida y suma su histograma al global. Ver GpuHistogram
+// (include/compute_primitives.h).
+// Con PER_GROUP_BINS cada workgroup deja su propio histograma, ordenado por
+// bin: bins[bin * grupos + grupo], como lo necesita GpuRadixSort.
+#ifndef LOCAL_SIZE_X
+#define LOCAL_SIZE_X 256
+#endif
+layout(local_size_x = LOCAL_SIZE_X, local_size_y = 1, local_size_z = 1) in;
+// potencia de dos
+#ifndef NUM_BINS
+#define NUM_BINS 256
+#endif
+
+layout(std430, binding = 0) readonly buffer Keys { uint keys[]; };
+// GpuHistogram lo pone a cero antes del dispatch si se le pide
+layout(std430, binding = 1) buffer Bins { uint bins[]; };
+uniform int count;
+uniform int shift;
+
+const uint ITEMS_PER_INVOCATION = 16u;
+const uint ELEMENTS_PER_GROUP = LOCAL_SIZE_X * ITEMS_PER_INVOCATION;
+
+shared uint localBins[NUM_BINS];
+
+void main() {
+    uint lid = gl_LocalInvocationID.x;
+    uint group = gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x;
+
+    for( uint b=lid; b<uint(NUM_BINS); b+=LOCAL_SIZE_X )
+        localBins[b] = 0u;
+    memoryBarrierShared();
+    barrier();
+
+    uint base = group * ELEMENTS_PER_GROUP + lid;
+    for( uint i=0u; i<ITEMS_PER_INVOCATION; i++ )
+    {
+        uint index = base + i * LOCAL_SIZE_X;
+        if( index<uint(count) )
+            atomicAdd( localBins[(keys[index] >> uint(shift)) & uint(NUM_BINS - 1)], 1u );
+    }
+    memoryBarrierShared();
+    barrier();
+
+#ifdef PER_GROUP_BINS
+    uint groupCount = (uint(count) + ELEMENTS_PER_GROUP - 1u) / ELEMENTS_PER_GROUP;
+    if( group<groupCount )
+        for( uint b=lid; b<uint(NUM_BINS); b+=LOCAL_SIZE_X )
+            bins[b * groupCount + group] = localBins[b];
+#else
+    for( uint b=lid; b<uint(NUM_BINS); b+=LOCAL_SIZE_X )
+        if( localBins[b]!=0u ) atomicAdd( bins[b], localBins[b] );
+#endif
+}
@@ -0,0 +1,81 @@
+#ifndef APP_CONTEXT_H
+#define APP_CONTEXT_H
+
+#include <glad/glad.h>
+#include <SDL3/SDL.h>
+
+#include <chrono>
+#include <string>
+
+// Command line switches shared by the executables. parse() removes the ones
+// it recognizes from argv, so the positional arguments each test already
+// takes keep their position.
+//   --headless         no window, the GL context comes from EGL
+//   --frames N         frames to run in headless mode
+//   --output file.ppm  write the last frame when a headless run ends
+//   --present MODE     blit, quad or readback, for executables using Presenter
+struct RunOptions
+{
+    static const int DEFAULT_HEADLESS_FRAMES = 300;
+
+    bool headless = false;
+    int frames = DEFAULT_HEADLESS_FRAMES;
+    std::string output;
+    std::string present;
+
+    static RunOptions parse(int& argc, char** argv);
+};
+
+// Window and GL 4.3 core context for the executables. Windowed it is the
+// usual SDL window + SDL_GL context. Headless it creates the context through
+// EGL on a pbuffer the size of the window (surfaceless if pbuffers are not
+// available), so Mesa llvmpipe works on machines without a display or GPU;
+// SDL is only initialized for events and timers.
+class AppContext
+{
+public:
+    // withGL = false only opens the window (for SDL_Renderer-only tests);
+    // headless there is then nothing to create
+    bool create(const char* title, int width, int height, const RunOptions& options, bool withGL = true);
+    // call once at the top of every frame; false once a headless run has done
+    // its frames. Windowed it always returns true, quitting stays event driven
+    bool nextFrame();
+    // lets the user resize the window; SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED
+    // then reports the new size. No effect headless
+    void setResizable(bool resizable);
+    // size of the default framebuffer in pixels (the create() size headless)
+    void getDrawableSize(int& width, int& height) const;
+    // makes the GL context current again, e.g. after SDL_Renderer drew with its own
+    void makeCurrent();
+    // SDL_GL_SwapWindow, or a flush when headless
+    void swap();
+    // prints frames and ms/frame of a headless run, then tears everything down
+    void destroy();
+
+    bool isHeadless() const { return options.headless; }
+    const RunOptions& getOptions() const { return options; }
+    SDL_Window* getWindow() const { return window; }
+    int getFrame() const { return frame; }
+
+private:
+    bool createHeadlessGL(int width, int height);
+
+    RunOptions options;
+    SDL_Window* window = nullptr;
+    SDL_GLContext glContext = nullptr;
+    void* eglDisplay = nullptr;
+    void* eglContext = nullptr;
+    void* eglSurface = nullptr;
+
+    int width = 0, height = 0;
+    int frame = 0;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Binary PPM from tightly packed RGBA8 rows; bottomUp for GL readbacks
+bool writeRGBA8PPM(const std::string& path, const unsigned char* rgba, int width, int height, bool bottomUp);
+// The bottom left width x height pixels of level 0 of a 2D texture as a PPM,
+// converted to RGBA8 by the driver
+bool saveTexturePPM(const std::string& path, GLuint texture, int width, int height);
+
+#endif
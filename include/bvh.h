@@ -0,0 +1,107 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <vector>
+
+#include "ray_packet.h"
+#include "sphere_scene.h"
+#include "thread_pool.h"
+
+// Flattened BVH node, 32 bytes so two nodes share a cache line. It matches
+// the std430 layout of
+//   struct BVHNode { vec3 bmin; int leftFirst; vec3 bmax; int count; };
+// Interior nodes have count == 0 and their children at leftFirst and
+// leftFirst + 1. Leaves hold spheres [leftFirst, leftFirst + count).
+struct BVHNode
+{
+    glm::vec3 boundsMin;
+    int leftFirst;
+    glm::vec3 boundsMax;
+    int count;
+
+    bool isLeaf() const { return count > 0; }
+};
+static_assert(sizeof(BVHNode) == 32, "BVHNode must match the std430 layout");
+
+// ssSphere of computeSh_test6.cs: 1 outside the sphere's soft shadow along
+// the unit ray rd, falling to 0 towards its center
+inline float softShadow(const glm::vec3& ro, const glm::vec3& rd, const glm::vec4& sph)
+{
+    glm::vec3 oc = glm::vec3(sph) - ro;
+    float b = glm::dot(oc, rd);
+    if (b <= 0.0f)
+        return 1.0f;
+    float h = glm::dot(oc, oc) - b * b - sph.w * sph.w;
+    float x = glm::clamp(12.0f * h / b, 0.0f, 1.0f);
+    return x * x * (3.0f - 2.0f * x);
+}
+
+// How much to grow a node's box so that a shadow ray (unit rd) that misses it
+// is outside the penumbra of every sphere in it. ssSphere darkens rays whose
+// closest approach d to a center satisfies d^2 < r^2 + b/12, where b is the
+// distance along the ray to that approach, so the penumbra widens with b.
+// The spheres are inside the box, so sqrt(b/12) is enough, with b bounded by
+// the box corner furthest along rd. Returns -1 when the whole box is behind
+// ro (b <= 0), where ssSphere is 1. computeSh_test6.cs has a GLSL copy.
+inline float shadowMargin(const BVHNode& node, const glm::vec3& ro, const glm::vec3& rd)
+{
+    glm::vec3 corner(rd.x >= 0.0f ? node.boundsMax.x : node.boundsMin.x,
+                     rd.y >= 0.0f ? node.boundsMax.y : node.boundsMin.y,
+                     rd.z >= 0.0f ? node.boundsMax.z : node.boundsMin.z);
+    float b = glm::dot(corner - ro, rd);
+    return b > 0.0f ? std::sqrt(b / 12.0f) : -1.0f;
+}
+
+// Bounding volume hierarchy over a SphereScene, built with binned SAH.
+// Subtrees above PARALLEL_THRESHOLD spheres are built on the thread pool.
+class SphereBVH
+{
+public:
+    static const GLuint NODES_BINDING = 3;
+    static const int MAX_LEAF_SIZE = 4;     // always a leaf at or below this
+    static const int MAX_DEPTH = 48;        // traversal stacks hold 64 entries
+    static const int SAH_BINS = 16;
+    static const int PARALLEL_THRESHOLD = 4096;
+
+    // owns the nodes buffer: move only, like SphereScene
+    SphereBVH() = default;
+    SphereBVH(const SphereBVH&) = delete;
+    SphereBVH& operator=(const SphereBVH&) = delete;
+    SphereBVH(SphereBVH&& other) noexcept;
+    SphereBVH& operator=(SphereBVH&& other) noexcept;
+
+    // Build over scene. The spheres are reordered so every leaf references a
+    // contiguous range; at most MAX_LEAF_SIZE spheres keep their order.
+    void build(SphereScene& scene, ThreadPool& pool = ThreadPool::global());
+
+    const std::vector<BVHNode>& getNodes() const { return nodes; }
+    int nodeCount() const { return (int)nodes.size(); }
+    int depth() const { return maxDepth; }
+
+    // Trace a packet front to back, running the packet kernel on every leaf
+    // that at least one of its rays can still hit.
+    void tracePacket(RayPacket& packet, const glm::vec3& ro, const SphereSceneView& spheres) const;
+
+    // Soft shadow along a unit rd, the product of ssSphere over the spheres
+    // near the ray: the CPU reference of shadowSpheres() in computeSh_test6.cs.
+    // Equal to the product over every sphere up to rounding.
+    float shadow(const glm::vec3& ro, const glm::vec3& rd, const SphereSceneView& spheres) const;
+
+    // GPU copy of the nodes at NODES_BINDING, same lifetime rules as SphereScene
+    void upload();
+    void bind() const;
+    void release();
+
+private:
+    struct Builder;
+
+    std::vector<BVHNode> nodes;
+    int maxDepth = 0;
+    GLuint nodesBuffer = 0;
+};
+
+#endif
@@ -65,10 +65,10 @@ private:
     glm::vec3 cameraUp    = glm::vec3(0.0f, 0.0f,  1.0f);
     glm::vec3 initCameraUp    = glm::vec3(0.0f, 0.0f,  1.0f);
 
-    bool OnUpperEdge;
-    bool OnLowerEdge;
-    bool OnLeftEdge;
-    bool OnRightEdge;
+    bool OnUpperEdge = false;
+    bool OnLowerEdge = false;
+    bool OnLeftEdge = false;
+    bool OnRightEdge = false;
 
     float mSpeed = 10.0f;
     
@@ -0,0 +1,133 @@
+#ifndef COMPUTE_PRIMITIVES_H
+#define COMPUTE_PRIMITIVES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "shader_c.h"
+#include "thread_pool.h"
+
+// Data-parallel building blocks over shader storage buffers, for frame-wide
+// statistics (average luminance, min/max depth, pixel histograms) without
+// reading the data back. Each one is a .cs kernel run through ComputeShader
+// and has a plain C++ reference below to check it against.
+//
+// Sizes are element counts. Inputs are read from binding 0, results go to
+// the buffers passed in; call glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT)
+// before running a primitive on the output of another kernel.
+
+enum class ReduceOp { Sum, Min, Max };
+
+// Workgroups for groupCount groups of a 1D kernel: a grid of x * y >= groupCount
+// with x within GL's minimum GL_MAX_COMPUTE_WORK_GROUP_COUNT. The kernels
+// flatten it back with gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x
+glm::uvec3 linearGroups(size_t groupCount);
+
+// reduce.cs: sum, min or max of a float buffer. Every pass shrinks the data
+// by ELEMENTS_PER_GROUP and the last one leaves the result in result()[0].
+class GpuReduce
+{
+public:
+    static const size_t ELEMENTS_PER_GROUP = 256 * 16;    // LOCAL_SIZE_X * ITEMS_PER_INVOCATION
+
+    bool create(ReduceOp op);
+    // reduce count floats of input; stays on the GPU
+    void dispatch(GLuint input, size_t count);
+    // the reduced value; waits for the GPU
+    float read() const;
+    // buffer holding the value at offset 0, to feed another kernel
+    GLuint result() const { return resultBuffer; }
+    void release();
+
+    ReduceOp op() const { return reduceOp; }
+
+private:
+    std::unique_ptr<ComputeShader> shader;
+    ReduceOp reduceOp = ReduceOp::Sum;
+    GLuint partials[2] = {};      // ping-pong between passes
+    size_t partialCapacity = 0;
+    GLuint resultBuffer = 0;
+};
+
+// scan.cs: exclusive prefix sum of a uint buffer in one pass with decoupled
+// look-back. output[i] = input[0] + ... + input[i - 1], wrapping at 2^32.
+class GpuScan
+{
+public:
+    static const size_t PARTITION_SIZE = 256 * 8;    // LOCAL_SIZE_X * ITEMS_PER_INVOCATION
+
+    bool create();
+    // output must hold count uints and may not alias input
+    void dispatch(GLuint input, GLuint output, size_t count);
+    void release();
+
+private:
+    std::unique_ptr<ComputeShader> shader;
+    GLuint stateBuffer = 0;       // look-back flags and totals of every partition
+    size_t stateCapacity = 0;
+};
+
+// histogram.cs: bins[(key >> shift) & (binCount - 1)] counts over a uint
+// buffer. With packed RGBA8 pixels, shift 0/8/16/24 picks the channel.
+class GpuHistogram
+{
+public:
+    static const size_t ELEMENTS_PER_GROUP = 256 * 16;
+
+    // binCount must be a power of two; the bins live in workgroup shared memory
+    bool create(int binCount = 256);
+    // bins holds binCount uints; clear false adds to the counts already there
+    void dispatch(GLuint keys, size_t count, GLuint bins, int shift = 0, bool clear = true);
+    void release();
+
+    int binCount() const { return bins; }
+
+private:
+    std::unique_ptr<ComputeShader> shader;
+    int bins = 0;
+};
+
+// LSD radix sort of 32-bit keys carrying 32-bit values, for Morton-ordered
+// spheres (BVH construction) and rays sorted by direction. Every pass sorts
+// on RADIX_BITS bits: histogram.cs counts digits per workgroup, GpuScan turns
+// the counts into offsets and radix_scatter.cs moves keys and values there,
+// stably. The result ends up back in the caller's buffers.
+class GpuRadixSort
+{
+public:
+    static const int RADIX_BITS = 4;
+    static const size_t PARTITION_SIZE = 256 * 16;    // per workgroup, as in histogram.cs
+
+    bool create();
+    // sorts count keys ascending, values follow their key; both buffers hold
+    // count uints. Keys must be below 2^keyBits (30 for 3D Morton codes):
+    // only the passes that cover those bits are run
+    void sort(GLuint keys, GLuint values, size_t count, int keyBits = 32);
+    void release();
+
+private:
+    std::unique_ptr<ComputeShader> histogramShader;
+    std::unique_ptr<ComputeShader> scatterShader;
+    GpuScan scan;
+    GLuint keysAlt = 0, valuesAlt = 0;    // ping-pong between passes
+    size_t altCapacity = 0;
+    GLuint countsBuffer = 0, offsetsBuffer = 0;
+    size_t countsCapacity = 0;
+};
+
+// References, sequential and written for clarity rather than speed
+float cpuReduce(const float* values, size_t count, ReduceOp op);
+void cpuExclusiveScan(const uint32_t* input, uint32_t* output, size_t count);
+void cpuHistogram(const uint32_t* keys, size_t count, uint32_t* bins, int binCount, int shift = 0);
+
+// Same sort on the CPU, 8 bits per pass: chunks of the arrays are counted
+// and scattered in parallel on pool. Reference for GpuRadixSort and the
+// fallback where there is no GL context.
+void cpuRadixSort(uint32_t* keys, uint32_t* values, size_t count, int keyBits = 32,
+                  ThreadPool& pool = ThreadPool::global());
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef CPU_COMPUTE_H
+#define CPU_COMPUTE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "thread_pool.h"
+
+// CPU execution of the .cs kernels, for hosts without a GPU. Each kernel is
+// hand ported to C++ (src/cpu_kernels.cpp) and registered under the file
+// name of its shader; ComputeShader picks the port up when it is created
+// with ComputeBackend::CPU.
+
+// Built-in variables of one invocation, same meaning as in GLSL
+struct CpuInvocation
+{
+    glm::uvec3 globalInvocationID;   // gl_GlobalInvocationID
+    glm::uvec3 localInvocationID;    // gl_LocalInvocationID
+    glm::uvec3 workGroupID;          // gl_WorkGroupID
+    glm::uvec3 numWorkGroups;        // gl_NumWorkGroups
+    glm::uvec3 workGroupSize;        // gl_WorkGroupSize
+    unsigned int localInvocationIndex;
+
+    void* shared;    // the workgroup's shared variables, CpuKernel::sharedSize() bytes
+    void* locals;    // this invocation's variables kept across barrier(), CpuKernel::localsSize() bytes
+};
+
+// Stand-in for an image2D binding. GL_RGBA8, GL_RGBA16F and GL_R11F_G11F_B10F
+// images quantize on store like imageStore does; GL_RGBA32F keeps the floats.
+class CpuImage
+{
+public:
+    CpuImage(int width, int height, GLenum internalFormat = GL_RGBA8);
+
+    int width() const { return w; }
+    int height() const { return h; }
+    GLenum format() const { return internalFormat; }
+
+    // out of range coordinates are ignored, as imageStore does
+    void store(const glm::ivec2& coords, const glm::vec4& value);
+    glm::vec4 load(const glm::ivec2& coords) const;
+
+    // rows bottom to top, GL_RGBA / GL_UNSIGNED_BYTE, like glReadPixels
+    void readRGBA8(std::vector<unsigned char>& out) const;
+    // binary PPM, top row first so the file looks like the window
+    bool writePPM(const std::string& path) const;
+
+private:
+    int w, h;
+    GLenum internalFormat;
+    std::vector<glm::vec4> texels;
+};
+
+// Uniform values set through ComputeShader::set*. Like GL, a value written
+// as float can be read back as int/bool and the other way around; unknown
+// names read as zero. Each name gets a slot on first use, which plays the
+// part of the uniform location for UniformHandle.
+class CpuUniforms
+{
+public:
+    int slot(const std::string& name);
+
+    void setFloats(int slot, const float* values, int count);
+    void setInts(int slot, const int* values, int count);
+    void setFloats(const std::string& name, const float* values, int count) { setFloats(slot(name), values, count); }
+    void setInts(const std::string& name, const int* values, int count) { setInts(slot(name), values, count); }
+
+    float getFloat(const std::string& name) const;
+    int getInt(const std::string& name) const;
+    bool getBool(const std::string& name) const { return getFloat(name) != 0.0f; }
+    glm::vec2 getVec2(const std::string& name) const;
+    glm::vec3 getVec3(const std::string& name) const;
+    glm::vec4 getVec4(const std::string& name) const;
+    glm::ivec2 getIVec2(const std::string& name) const;
+    glm::mat4 getMat4(const std::string& name) const;
+
+private:
+    struct Value
+    {
+        float f[16] = {};
+        int i[16] = {};
+    };
+    const Value* find(const std::string& name) const;
+
+    std::unordered_map<std::string, int> slots;
+    std::vector<Value> values;
+};
+
+// Image units, shader storage and uniform buffers visible to a dispatch
+struct CpuBindings
+{
+    static const int MAX_BINDINGS = 8;
+
+    CpuImage* images[MAX_BINDINGS] = {};
+    const void* buffers[MAX_BINDINGS] = {};
+    std::size_t bufferSizes[MAX_BINDINGS] = {};
+    const void* uniformBuffers[MAX_BINDINGS] = {};
+};
+
+class CpuKernel
+{
+public:
+    virtual ~CpuKernel() = default;
+
+    // layout(local_size_x, local_size_y, local_size_z) of the original shader
+    virtual glm::uvec3 localSize() const = 0;
+    // read uniforms and bindings once, before any invocation of a dispatch runs
+    virtual void prepare(const CpuUniforms& uniforms, const CpuBindings& bindings) = 0;
+    // body of main(); called concurrently for invocations of different workgroups
+    virtual void invoke(const CpuInvocation& invocation) const = 0;
+
+    // Kernels with shared variables and barrier() are ported as phases: main()
+    // split at its barriers, so a kernel with n barriers has n + 1 phases.
+    // Every invocation of a workgroup runs a phase before any of them starts
+    // the next one, which is all barrier() guarantees. Locals that live across
+    // a barrier go in CpuInvocation::locals, shared variables in ::shared.
+    virtual int barrierCount() const { return 0; }
+    // bytes of shared variables for a workgroup of localSize invocations
+    virtual std::size_t sharedSize(const glm::uvec3& /*localSize*/) const { return 0; }
+    virtual std::size_t localsSize() const { return 0; }
+    // phase of main() between barrier number phase - 1 and phase
+    virtual void invokePhase(const CpuInvocation& invocation, int /*phase*/) const { invoke(invocation); }
+};
+
+typedef std::unique_ptr<CpuKernel> (*CpuKernelFactory)();
+
+// register a port under the shader file name (e.g. "computeShader.cs")
+void registerCpuKernel(const std::string& shaderName, CpuKernelFactory factory);
+// port for a shader path, matched on its file name; nullptr if there is none
+std::unique_ptr<CpuKernel> createCpuKernel(const std::string& shaderPath);
+// defined in cpu_kernels.cpp, registers the ports of the repo's kernels
+void registerBuiltinCpuKernels();
+
+// workgroups per dimension of a CPU dispatch, the GL_MAX_COMPUTE_WORK_GROUP_COUNT
+// every GL 4.3 driver supports; larger dispatches run nothing, as on the GPU
+const unsigned int CPU_MAX_WORK_GROUP_COUNT = 65535;
+
+// Run numGroups workgroups of kernel. Workgroups are spread across the pool,
+// the invocations of one workgroup run in order on a single thread, one
+// phase at a time (see CpuKernel::barrierCount).
+void cpuDispatch(CpuKernel& kernel, const glm::uvec3& numGroups, ThreadPool& pool = ThreadPool::global());
+// same with workgroups of localSize instead of the kernel's own, as
+// WorkgroupTuner candidates do; shared memory is sized for localSize
+void cpuDispatch(CpuKernel& kernel, const glm::uvec3& numGroups, const glm::uvec3& localSize,
+                 ThreadPool& pool = ThreadPool::global());
+
+// Program state of a ComputeShader running on the CPU backend
+struct CpuProgram
+{
+    std::unique_ptr<CpuKernel> kernel;
+    CpuUniforms uniforms;
+    CpuBindings bindings;
+    glm::uvec3 localSize = glm::uvec3(0);   // 0: the kernel's own
+
+    void dispatch(const glm::uvec3& numGroups)
+    {
+        kernel->prepare(uniforms, bindings);
+        cpuDispatch(*kernel, numGroups, localSize.x ? localSize : kernel->localSize());
+    }
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef FRAME_PARAMS_H
+#define FRAME_PARAMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// Per-frame parameters of computeSh_test6.cs. The layout matches
+//   layout(std140, binding = 0) uniform FrameParams {
+//       mat4 viewMatrix;
+//       vec3 front;     float iTime;
+//       vec3 up;        float FOV;
+//       vec3 right;     int   sphereCount;
+//       vec3 cameraPos;
+//       vec2 screenResolution;
+//       bool show_grid; bool  show_axis;
+//   };
+// std140 aligns vec3 to 16 bytes, so each one is followed by a 4 byte field
+// (or padding) instead of being widened to vec4.
+struct FrameParams
+{
+    static const GLuint BINDING = 0;
+
+    glm::mat4 viewMatrix;
+    glm::vec3 front;
+    float iTime;
+    glm::vec3 up;
+    float FOV;
+    glm::vec3 right;
+    int sphereCount;
+    glm::vec3 cameraPos;
+    int pad0;
+    glm::vec2 screenResolution;
+    int showGrid;   // GLSL bool is 4 bytes in std140
+    int showAxis;
+};
+static_assert(offsetof(FrameParams, front) == 64, "FrameParams must match std140");
+static_assert(offsetof(FrameParams, cameraPos) == 112, "FrameParams must match std140");
+static_assert(offsetof(FrameParams, screenResolution) == 128, "FrameParams must match std140");
+static_assert(sizeof(FrameParams) == 144, "FrameParams must match std140");
+
+#endif
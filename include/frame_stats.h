@@ -0,0 +1,44 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Frame times of a benchmark run, in milliseconds. Percentiles use the
+// nearest-rank method, so p99 of 100 frames is the slowest frame.
+class FrameStats
+{
+public:
+    void add(double ms) { times.push_back(ms); sorted = false; }
+    void clear() { times.clear(); sorted = true; }
+
+    size_t count() const { return times.size(); }
+    double min() { return percentile(0.0); }
+    double median() { return percentile(50.0); }
+    double max() { return percentile(100.0); }
+
+    double percentile(double p) {
+        if (times.empty())
+            return 0.0;
+        if (!sorted) {
+            std::sort(times.begin(), times.end());
+            sorted = true;
+        }
+        size_t rank = (size_t)std::ceil(p / 100.0 * times.size());
+        return times[rank > 0 ? rank - 1 : 0];
+    }
+
+    double mean() const {
+        double total = 0.0;
+        for (double t : times)
+            total += t;
+        return times.empty() ? 0.0 : total / times.size();
+    }
+
+private:
+    std::vector<double> times;
+    bool sorted = true;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <glad/glad.h>
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-stage GPU time from GL_TIMESTAMP queries. Every scope writes a
+// timestamp when it opens and one when it closes (glQueryCounter), so scopes
+// can nest, which GL_TIME_ELAPSED queries cannot.
+//
+// Queries go into one pool per frame in flight. beginFrame() reads the pool
+// it is about to reuse, written framesInFlight frames ago, and only if the
+// GPU has finished it.
+// Reading never stalls; a frame whose results are not in yet is skipped and
+// counted in skippedFrames().
+//
+//   profiler.beginFrame();
+//   { GpuScope scope(profiler, "dispatch"); glDispatchCompute(...); }
+//   profiler.endFrame();
+class GpuProfiler
+{
+public:
+    static const int DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+    void create(int framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
+    void release();
+
+    void beginFrame();
+    void endFrame();
+    // open/close a stage; returns the handle end() takes. Prefer GpuScope
+    int begin(const char* stage);
+    void end(int scope);
+
+    // false when the driver has no timestamp counter; every call is then a no-op
+    bool isEnabled() const { return enabled; }
+    // GPU ms of the last resolved frame and average since the last reset
+    double lastMs(const std::string& stage) const;
+    double averageMs(const std::string& stage) const;
+    long long skippedFrames() const { return skipped; }
+
+    // one line with the average of every stage (and the whole frame), then resets the averages
+    void print(std::ostream& out);
+    void resetAverages();
+
+private:
+    struct Scope {
+        int stage;
+        GLuint beginQuery;
+        GLuint endQuery;
+    };
+    struct Frame {
+        std::vector<GLuint> queries;    // pool, grows to the most scopes seen in one frame
+        int used = 0;
+        std::vector<Scope> scopes;
+        bool pending = false;
+    };
+    struct Stage {
+        std::string name;
+        double last = 0.0;
+        double total = 0.0;
+        long long samples = 0;
+    };
+
+    GLuint nextQuery(Frame& frame);
+    bool resolve(Frame& frame);
+    int stageIndex(const char* name);
+
+    bool enabled = false;
+    std::vector<Frame> frames;
+    int current = 0;
+    bool inFrame = false;
+    int frameScope = -1;
+    std::vector<Stage> stages;
+    std::unordered_map<std::string, int> stageIndices;
+    long long skipped = 0;
+};
+
+// Times the enclosing block on the GPU
+class GpuScope
+{
+public:
+    GpuScope(GpuProfiler& profiler, const char* stage) : profiler(profiler), scope(profiler.begin(stage)) {}
+    ~GpuScope() { profiler.end(scope); }
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+
+private:
+    GpuProfiler& profiler;
+    int scope;
+};
+
+#endif
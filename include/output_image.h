@@ -0,0 +1,56 @@
+#ifndef OUTPUT_IMAGE_H
+#define OUTPUT_IMAGE_H
+
+#include <glad/glad.h>
+
+#include <ostream>
+#include <string>
+
+// Formats a kernel can write its output image in. The .cs files declare the
+// image as layout(OUTPUT_FORMAT, ...) so the format is picked per kernel at
+// build time, through the same #define prelude as the workgroup size.
+enum class ImageFormat { RGBA8, RGBA16F, R11G11B10F, RGBA32F };
+
+struct ImageFormatInfo
+{
+    ImageFormat format;
+    GLenum internalFormat;    // glTexStorage2D / glBindImageTexture
+    const char* glsl;         // image format layout qualifier
+    const char* name;
+    int bytesPerPixel;
+};
+
+const ImageFormatInfo& imageFormatInfo(ImageFormat format);
+// "#define OUTPUT_FORMAT rgba16f\n", to pass to ProgramBuilder::compute
+std::string imageFormatDefines(ImageFormat format);
+
+// The image a compute kernel renders into: one immutable level allocated
+// with glTexStorage2D, so the size and format are fixed for its lifetime.
+class OutputImage
+{
+public:
+    // filter is used when the image is sampled (main.cpp's screen quad)
+    void create(int width, int height, ImageFormat format, GLenum filter = GL_NEAREST);
+    // glBindImageTexture with the image's own format
+    void bindImage(GLuint unit, GLenum access = GL_WRITE_ONLY) const;
+    void release();
+
+    GLuint texture() const { return tex; }
+    int width() const { return w; }
+    int height() const { return h; }
+    ImageFormat format() const { return fmt; }
+    GLenum internalFormat() const { return imageFormatInfo(fmt).internalFormat; }
+    size_t bytes() const { return (size_t)w * h * imageFormatInfo(fmt).bytesPerPixel; }
+    std::string defines() const { return imageFormatDefines(fmt); }
+
+private:
+    GLuint tex = 0;
+    int w = 0, h = 0;
+    ImageFormat fmt = ImageFormat::RGBA8;
+};
+
+// Size of a width x height image in every format and the bandwidth it takes
+// at fps, counting one full write by the kernel and one full read to present
+void printImageFootprint(std::ostream& out, int width, int height, double fps = 60.0);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef PBO_READBACK_H
+#define PBO_READBACK_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+// Ring of pixel pack buffers for reading frames back without waiting on the
+// GPU. readPixels() queues a glReadPixels into the next buffer and fences
+// it; map() hands out the frame queued depth - 1 calls earlier, by which
+// time the copy is usually done. A depth of 1 behaves like a single PBO
+// mapped right after the read (a full stall every frame).
+//
+// In Persistent mode the buffers are allocated with glBufferStorage and
+// mapped once (persistent + coherent), so map() only waits on the fence and
+// returns the pointer; unmap() just releases the slot. It needs
+// ARB_buffer_storage and falls back to MapPerFrame without it.
+enum class ReadbackMode { MapPerFrame, Persistent };
+
+class PboReadback
+{
+public:
+    static const int DEFAULT_DEPTH = 3;
+
+    void create(int width, int height, int depth = DEFAULT_DEPTH,
+                GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE,
+                ReadbackMode mode = ReadbackMode::MapPerFrame);
+    // read the bound GL_READ_FRAMEBUFFER into the next buffer; if the ring is
+    // full the oldest frame, never mapped, is dropped. Returns false, reading
+    // nothing, when the ring is full and a frame is still mapped: unmap() first
+    bool readPixels();
+    // oldest queued frame, nullptr while the ring is still filling up.
+    // Rows go bottom to top, as glReadPixels writes them. Call unmap() when done.
+    const void* map();
+    void unmap();
+    void release();
+
+    int getDepth() const { return depth; }
+    bool isPersistent() const { return !mappings.empty(); }
+    size_t frameBytes() const { return bytes; }
+    // time map() spent waiting for the GPU, last call and average over the
+    // calls since create() or resetStallStats()
+    double lastStallMs() const { return lastStall; }
+    double averageStallMs() const { return mappedFrames > 0 ? totalStall / mappedFrames : 0.0; }
+    // start the average over, e.g. once the ring has filled up
+    void resetStallStats() { lastStall = totalStall = 0.0; mappedFrames = 0; }
+
+private:
+    void dropOldest();
+
+    int width = 0, height = 0, depth = 0;
+    GLenum format = GL_RGBA, type = GL_UNSIGNED_BYTE;
+    size_t bytes = 0;
+    std::vector<GLuint> pbos;
+    std::vector<GLsync> fences;
+    std::vector<const void*> mappings;  // persistent mode only
+    int head = 0;       // next buffer to read into
+    int pending = 0;    // frames queued and not unmapped yet
+    int mappedSlot = -1;
+
+    double lastStall = 0.0;
+    double totalStall = 0.0;
+    long long mappedFrames = 0;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <vector>
+
+// Hardware cache counters of the whole process, for the CPU renderers: last
+// level cache references and misses through perf_event_open, user space only.
+// Linux only; elsewhere, or where the kernel refuses (perf_event_paranoid
+// above 2, containers, VMs without a PMU), create() returns false.
+//
+//   PerfCounters counters;
+//   counters.create();          // after the thread pool is running
+//   counters.start();
+//   ... render ...
+//   counters.stop();
+//   counters.cacheMisses();
+class PerfCounters
+{
+public:
+    PerfCounters() = default;
+    ~PerfCounters() { release(); }
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // opens the counters on every thread the process has now; threads
+    // started later are not counted
+    bool create();
+    void release();
+    bool available() const { return !threads.empty(); }
+
+    // zero the counts and count until stop()
+    void start();
+    void stop();
+
+    // counted between start() and stop(), summed over the threads
+    uint64_t cacheReferences() const { return references; }
+    uint64_t cacheMisses() const { return misses; }
+
+private:
+    struct ThreadCounters {
+        int references;    // group leader, reads both counts at once
+        int misses;
+    };
+    std::vector<ThreadCounters> threads;
+    uint64_t references = 0;
+    uint64_t misses = 0;
+};
+
+#endif
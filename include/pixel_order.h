@@ -0,0 +1,69 @@
+#ifndef PIXEL_ORDER_H
+#define PIXEL_ORDER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+// Order in which the renderers walk the pixels of a frame. RowMajor is the
+// plain gl_GlobalInvocationID / y * width + x mapping. Morton visits
+// workgroups (GPU) or tiles (CPU) along a Z curve inside square blocks of
+// MORTON_BLOCK x MORTON_BLOCK, and the invocations of a square power of two
+// workgroup along a Z curve too, so work that runs close in time touches
+// neighbouring pixels, BVH nodes and cache lines. The GLSL copies live in
+// computeShader2.cs and computeSh_test6.cs (uniform int pixelOrder); keep
+// them in sync with these.
+enum class PixelOrder { RowMajor = 0, Morton = 1 };
+
+// workgroups / tiles per side of a Z curve block; blocks go in row-major order
+const uint32_t MORTON_BLOCK = 8;
+
+inline const char* pixelOrderName(PixelOrder order)
+{
+    return order == PixelOrder::Morton ? "morton" : "row_major";
+}
+
+// keeps the even bits of v, packed into the low 16
+inline uint32_t compactBits(uint32_t v)
+{
+    v &= 0x55555555u;
+    v = (v | (v >> 1)) & 0x33333333u;
+    v = (v | (v >> 2)) & 0x0f0f0f0fu;
+    v = (v | (v >> 4)) & 0x00ff00ffu;
+    v = (v | (v >> 8)) & 0x0000ffffu;
+    return v;
+}
+
+// Z curve index -> (x, y): even bits go to x, odd bits to y
+inline glm::uvec2 mortonDecode(uint32_t code)
+{
+    return glm::uvec2(compactBits(code), compactBits(code >> 1));
+}
+
+// Cell of a grid.x x grid.y grid visited index-th in Morton order. Every
+// index below grid.x * grid.y maps to a different cell, whatever the grid
+// size: blocks cut by the right or bottom edge are walked row by row.
+inline glm::uvec2 mortonCell(uint32_t index, const glm::uvec2& grid)
+{
+    const uint32_t B = MORTON_BLOCK;
+    uint32_t band = index / (grid.x * B);                  // row of blocks
+    uint32_t rows = std::min(B, grid.y - band * B);
+    uint32_t inBand = index - band * grid.x * B;
+    uint32_t block = inBand / (B * rows);
+    uint32_t cols = std::min(B, grid.x - block * B);
+    uint32_t inBlock = inBand - block * B * rows;
+    glm::uvec2 cell = (cols == B && rows == B) ? mortonDecode(inBlock) : glm::uvec2(inBlock % cols, inBlock / cols);
+    return glm::uvec2(block * B, band * B) + cell;
+}
+
+// Position inside a size.x x size.y workgroup of its index-th invocation:
+// along a Z curve when the workgroup is square with a power of two side,
+// row-major otherwise
+inline glm::uvec2 mortonLocal(uint32_t index, const glm::uvec2& size)
+{
+    bool square = size.x == size.y && (size.x & (size.x - 1u)) == 0u;
+    return square ? mortonDecode(index) : glm::uvec2(index % size.x, index / size.x);
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef PRESENTER_H
+#define PRESENTER_H
+
+#include <glad/glad.h>
+#include <SDL3/SDL.h>
+
+#include <vector>
+
+#include "app_context.h"
+#include "pbo_readback.h"
+
+// How a finished compute image reaches the window.
+//   Blit      glBlitFramebuffer into the default framebuffer, then swap
+//   Quad      fullscreen quad sampling the image (screenQuad.vs/.fs), then swap
+//   Readback  PBO ring to the CPU and SDL_UpdateTexture into an SDL_Renderer,
+//             so every frame goes GPU -> CPU -> GPU
+// Blit and Quad never leave the GPU; Blit is the default.
+enum class PresentMode { Blit, Quad, Readback };
+
+class Presenter
+{
+public:
+    // "blit", "quad" or "readback"; false leaves mode untouched
+    static bool parseMode(const char* name, PresentMode& mode);
+    static const char* modeName(PresentMode mode);
+
+    // readbackDepth / readbackMode configure the PBO ring of Readback mode
+    bool create(AppContext& app, PresentMode mode = PresentMode::Blit,
+                int readbackDepth = PboReadback::DEFAULT_DEPTH,
+                ReadbackMode readbackMode = ReadbackMode::MapPerFrame);
+    // shows the bottom left width x height of texture scaled to the window
+    // and swaps. Readback mode shows the frame read depth - 1 calls earlier
+    void present(GLuint texture, int width, int height);
+    void release();
+
+    PresentMode mode() const { return presentMode; }
+    // Readback mode only, nullptr otherwise
+    const PboReadback* readback() const { return presentMode == PresentMode::Readback ? &pbo : nullptr; }
+
+private:
+    void attach(GLuint texture);
+    void blit(int width, int height);
+    void drawQuad(GLuint texture, int width, int height);
+    void readBack(int width, int height);
+
+    AppContext* app = nullptr;
+    PresentMode presentMode = PresentMode::Blit;
+    GLuint readFramebuffer = 0;
+    GLuint attached = 0;
+
+    // Quad
+    GLuint quadProgram = 0;
+    GLint texScaleLocation = -1;
+    GLuint quadVAO = 0, quadVBO = 0;
+
+    // Readback
+    PboReadback pbo;
+    int pboDepth = PboReadback::DEFAULT_DEPTH;
+    ReadbackMode pboMode = ReadbackMode::MapPerFrame;
+    int readWidth = 0, readHeight = 0;
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* sdlTexture = nullptr;
+    std::vector<unsigned char> cpuFrame;    // headless: stands in for the SDL texture
+};
+
+#endif
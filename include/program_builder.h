@@ -0,0 +1,66 @@
+#ifndef PROGRAM_BUILDER_H
+#define PROGRAM_BUILDER_H
+
+#include <glad/glad.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Program whose compile and link were submitted but not waited for. Handles
+// are shared: copies refer to the same program.
+class ProgramFuture
+{
+public:
+    ProgramFuture() = default;
+
+    bool valid() const { return (bool)state; }
+    // true once get() would not block. Never blocks; without
+    // KHR_parallel_shader_compile it is always true
+    bool ready() const;
+    // the linked program, 0 if compiling or linking failed. Waits for the
+    // driver the first time, reports the info logs and frees the shaders
+    GLuint get();
+    // prelude it was built with (see ProgramBuilder::compute)
+    const std::string& defines() const;
+
+private:
+    friend class ProgramBuilder;
+    struct State {
+        GLuint program = 0;
+        std::vector<GLuint> shaders;
+        std::vector<std::string> stages;    // "COMPUTE", "VERTEX"... for the error messages
+        std::string cacheSource;            // kept for ProgramCache; empty for graphics programs
+        std::string defines;
+        bool finished = false;
+        bool linked = false;
+    };
+    std::shared_ptr<State> state;
+};
+
+// Starts compiles and links without querying their status, so the driver can
+// run them on its own compiler threads (KHR_parallel_shader_compile) while
+// the caller creates windows, textures and buffers. Submit everything first,
+// then hand the futures to the Shader / ComputeShader constructors:
+//
+//   ProgramFuture compute = ProgramBuilder::compute("computeShader.cs");
+//   ProgramFuture quad = ProgramBuilder::graphics("screenQuad.vs", "screenQuad.fs");
+//   ... create textures ...
+//   ComputeShader computeShader(compute);
+//   Shader screenQuad(quad);
+//
+// Compute programs go through ProgramCache; a cache hit is ready at once.
+// defines ("#define NAME value" lines) go right after the #version line.
+class ProgramBuilder
+{
+public:
+    static ProgramFuture compute(const char* computePath, const std::string& defines = "");
+    static ProgramFuture graphics(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
+
+    // waits for every future, for callers that submitted a batch
+    static void finishAll(std::vector<ProgramFuture>& futures);
+    // whether the driver compiles in the background
+    static bool isParallel();
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <string>
+
+// On-disk cache of linked program binaries (glGetProgramBinary). An entry is
+// keyed by a hash of the shader source together with the GL vendor,
+// renderer and version strings, so a driver update or a different GPU
+// misses instead of loading a binary the driver would reject. The full key
+// is stored in the entry as well and compared on load.
+//
+// Entries are written to a temporary file and renamed into place, so a
+// crash or a second process never leaves a half-written entry behind. An
+// entry the driver refuses (GL_LINK_STATUS false after glProgramBinary) is
+// deleted and the caller compiles from source.
+//
+// The directory is "program_cache" next to the working directory, or
+// whatever CS_PROGRAM_CACHE names; CS_PROGRAM_CACHE=off disables it.
+class ProgramCache
+{
+public:
+    static ProgramCache& global();
+
+    // program linked from the cached binary, 0 on a miss or stale entry
+    GLuint load(const std::string& source);
+    // keep the binary of a linked program; it must have been linked with
+    // GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+    void store(const std::string& source, GLuint program);
+
+    void setDirectory(const std::string& directory) { this->directory = directory; }
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    // off when disabled or when the driver offers no binary formats
+    bool isEnabled() const;
+    const std::string& getDirectory() const { return directory; }
+
+    int hits() const { return hitCount; }
+    int misses() const { return missCount; }
+
+private:
+    ProgramCache();
+    std::string driverKey() const;
+    std::string entryPath(const std::string& key) const;
+
+    std::string directory;
+    bool enabled = true;
+    int hitCount = 0;
+    int missCount = 0;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef PROGRESSIVE_H
+#define PROGRESSIVE_H
+
+#include <glm/glm.hpp>
+#include <cmath>
+
+#include "camera3.h"
+
+// Progressive rendering of a still camera: every frame adds one jittered
+// sample per pixel to an RGBA32F accumulation image and shows the running
+// mean, so a static view converges to an antialiased image. Moving the
+// camera (a different getView() or getFov()) starts over from sample 0,
+// which is the same ray as the non-progressive renderers. Other changes
+// to the image (resize, toggles) call reset().
+//
+//   int sample = progressive.nextSample(camera);
+//   if (sample >= 0)
+//       ... render sample, averaging it into the accumulation image ...
+//   else
+//       ... show the mean of sampleCount() samples as it is ...
+class ProgressiveState
+{
+public:
+    // past this the image is left as it is until something changes
+    static const int MAX_SAMPLES = 1024;
+
+    // index of the sample to render this frame, or -1 once MAX_SAMPLES are in
+    int nextSample(Camera& camera)
+    {
+        glm::mat4 view = camera.getView();
+        float fov = camera.getFov();
+        if (view != lastView || fov != lastFov)
+            samples = 0;
+        lastView = view;
+        lastFov = fov;
+        if (samples >= MAX_SAMPLES)
+            return -1;
+        return samples++;
+    }
+    void reset() { samples = 0; }
+
+    // samples in the accumulation image after this frame's
+    int sampleCount() const { return samples; }
+    bool converged() const { return samples >= MAX_SAMPLES; }
+
+    // Offset of a sample inside its pixel, in [0, 1)^2: the R2 low discrepancy
+    // sequence, which covers the pixel evenly at any sample count. Sample 0
+    // is (0, 0), the corner the non-progressive rays go through.
+    static glm::vec2 jitter(int sample)
+    {
+        const glm::vec2 R2(0.7548776662f, 0.5698402910f);    // 1/g, 1/g^2 with g the plastic number
+        glm::vec2 v = (float)sample * R2;
+        return v - glm::floor(v);
+    }
+
+private:
+    glm::mat4 lastView = glm::mat4(0.0f);
+    float lastFov = -1.0f;
+    int samples = 0;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef RAY_PACKET_H
+#define RAY_PACKET_H
+
+#include <glm/glm.hpp>
+
+#include "sphere_scene.h"
+
+// A row of primary rays sharing the camera origin, stored as structure of
+// arrays so the kernels can load 8 (AVX2) or 16 (AVX-512) directions at once.
+struct RayPacket
+{
+    static const int MAX_RAYS = 64;
+
+    int count = 0;
+    alignas(64) float dirX[MAX_RAYS];
+    alignas(64) float dirY[MAX_RAYS];
+    alignas(64) float dirZ[MAX_RAYS];
+    alignas(64) float tmin[MAX_RAYS];
+    alignas(64) float colR[MAX_RAYS];
+    alignas(64) float colG[MAX_RAYS];
+    alignas(64) float colB[MAX_RAYS];
+
+    // clear hits/colors of all lanes (padding lanes included) for count rays
+    void reset(int rayCount);
+    void setDirection(int lane, const glm::vec3& rd)
+    {
+        dirX[lane] = rd.x;
+        dirY[lane] = rd.y;
+        dirZ[lane] = rd.z;
+    }
+    glm::vec3 color(int lane) const { return glm::vec3(colR[lane], colG[lane], colB[lane]); }
+};
+
+// Intersect every ray of the packet with spheres [first, last) and shade the
+// closest hits the same way the scalar iSphere loop of test7 does. Can be
+// called repeatedly on the same packet (e.g. once per BVH leaf).
+void tracePacket(RayPacket& packet, const glm::vec3& ro, const SphereSceneView& spheres, int first, int last);
+
+// Kernel picked at runtime: "avx512", "avx2" or "scalar". Setting the
+// RAY_PACKET_ISA environment variable to one of these names caps the choice.
+const char* rayPacketKernelName();
+
+#endif
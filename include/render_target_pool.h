@@ -0,0 +1,81 @@
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Immutable-storage textures (glTexStorage2D, one level) handed out by
+// format and size. Sizes are rounded up to SIZE_STEP, so textures for
+// nearby sizes are interchangeable, and released textures wait in the pool
+// until a matching acquire() takes them back. Only MAX_IDLE textures are
+// kept idle; older ones are deleted. Every texture the pool creates is
+// deleted by release() at the latest.
+class RenderTargetPool
+{
+public:
+    static const int SIZE_STEP = 128;
+    static const int MAX_IDLE = 4;
+
+    RenderTargetPool() = default;
+    ~RenderTargetPool() { release(); }
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    // texture of at least width x height; its real size is allocatedWidth/Height()
+    GLuint acquire(GLenum format, int width, int height);
+    // give a texture from acquire() back for reuse
+    void recycle(GLuint texture);
+    // deletes every texture, idle or not
+    void release();
+
+    int allocatedWidth(GLuint texture) const;
+    int allocatedHeight(GLuint texture) const;
+
+    // textures alive (handed out plus idle) and glTexStorage2D calls so far
+    int textureCount() const { return (int)entries.size(); }
+    int allocations() const { return allocationCount; }
+
+    static int roundUp(int size) { return (size + SIZE_STEP - 1) / SIZE_STEP * SIZE_STEP; }
+
+private:
+    struct Entry {
+        GLuint texture;
+        GLenum format;
+        int width, height;    // allocated, multiples of SIZE_STEP
+        bool inUse;
+        long long releasedAt;
+    };
+    const Entry* find(GLuint texture) const;
+
+    std::vector<Entry> entries;
+    long long releaseCounter = 0;
+    int allocationCount = 0;
+};
+
+// One output image that follows the window. The image is the top left
+// width() x height() corner of a pooled texture, so a resize that still fits
+// in the texture (and is not much smaller) only changes the logical size;
+// kernels are dispatched with ComputeShader::dispatchFor(width(), height())
+// and blits read that corner.
+class RenderTarget
+{
+public:
+    void create(RenderTargetPool& pool, GLenum format, int width, int height);
+    // true when the texture changed: bind the new one (image unit, framebuffer)
+    bool resize(int width, int height);
+    void release();
+
+    GLuint texture() const { return tex; }
+    GLenum format() const { return internalFormat; }
+    int width() const { return w; }
+    int height() const { return h; }
+
+private:
+    RenderTargetPool* pool = nullptr;
+    GLuint tex = 0;
+    GLenum internalFormat = GL_RGBA8;
+    int w = 0, h = 0;
+};
+
+#endif
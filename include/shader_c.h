@@ -5,9 +5,16 @@
 #include <glm/glm.hpp>
 
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <iostream>
+#include <memory>
+
+#include "cpu_compute.h"
+#include "uniform_cache.h"
+#include "program_builder.h"
+#include "workgroup_size.h"
+
+// GL compiles the .cs file; CPU runs its C++ port (see cpu_compute.h)
+enum class ComputeBackend { GL, CPU };
 
 class ComputeShader
 {
@@ -15,164 +22,338 @@ public:
     unsigned int ID;
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
-    ComputeShader(const char* computePath)
+    ComputeShader(const char* computePath, ComputeBackend backend = ComputeBackend::GL)
+        : ComputeShader(computePath, WorkgroupSize(), backend)
     {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string computeCode;
-        std::ifstream cShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try
-        {
-            // open files
-            cShaderFile.open(computePath);
-
-            std::stringstream cShaderStream;
-            // read file's buffer contents into streams
-            cShaderStream << cShaderFile.rdbuf();
-            // close file handlers
-            cShaderFile.close();
-            // convert stream into string
-            computeCode = cShaderStream.str();
-        }
-        catch (std::ifstream::failure& e)
+    }
+    // same with the workgroup size picked by WorkgroupTuner instead of the one in the file
+    // ------------------------------------------------------------------------
+    ComputeShader(const char* computePath, const WorkgroupSize& size, ComputeBackend backend = ComputeBackend::GL)
+    {
+        if (backend == ComputeBackend::CPU)
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+            ID = 0;
+            cpu = std::make_shared<CpuProgram>();
+            cpu->kernel = createCpuKernel(computePath);
+            cpu->localSize = size.local;
+            extentUniform = uniform("dispatchExtent");
+            if (!cpu->kernel)
+                std::cout << "ERROR::SHADER::NO_CPU_KERNEL for " << computePath << std::endl;
+            return;
         }
-        const char* cShaderCode = computeCode.c_str();
-        // 2. compile shaders
-        unsigned int compute;
-        // compute shader
-        compute = glCreateShader(GL_COMPUTE_SHADER);
-        glShaderSource(compute, 1, &cShaderCode, NULL);
-        glCompileShader(compute);
-        checkCompileErrors(compute, "COMPUTE");
-        
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, compute);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(compute);
+        // compile, link and wait; ProgramBuilder::compute() lets the caller overlap the wait
+        defines = size.defines();
+        ID = ProgramBuilder::compute(computePath, defines).get();
+        uniforms.build(ID);
+        local = queryLocalSize(ID);
+        extentUniform = uniform("dispatchExtent");
+    }
+    // adopt a program submitted earlier with ProgramBuilder::compute(); waits if it is not ready yet
+    // ------------------------------------------------------------------------
+    ComputeShader(ProgramFuture program)
+    {
+        defines = program.defines();
+        ID = program.get();
+        uniforms.build(ID);
+        local = queryLocalSize(ID);
+        extentUniform = uniform("dispatchExtent");
+    }
+    // hot reload: start rebuilding from computePath in the background. The
+    // current program stays in use until swapIfReady() finds the new one linked
+    // ------------------------------------------------------------------------
+    void reload(const char* computePath)
+    {
+        if (cpu) return;
+        pending = ProgramBuilder::compute(computePath, defines);
+    }
+    // call between frames. Swaps in a finished rebuild and re-resolves the
+    // uniforms; returns true if the program changed, so handles from uniform()
+    // must be resolved again. A rebuild that fails to compile is dropped
+    // ------------------------------------------------------------------------
+    bool swapIfReady()
+    {
+        if (!pending.valid() || !pending.ready())
+            return false;
+        GLuint program = pending.get();
+        pending = ProgramFuture();
+        if (program == 0)
+            return false;
+        glDeleteProgram(ID);
+        ID = program;
+        uniforms.build(ID);
+        local = queryLocalSize(ID);
+        extentUniform = uniform("dispatchExtent");
+        return true;
     }
     // activate the shader
     // ------------------------------------------------------------------------
     void use() 
     { 
+        if (cpu) return;
         glUseProgram(ID); 
     }
+    // run the kernel, same arguments as glDispatchCompute
+    // ------------------------------------------------------------------------
+    void dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ) const
+    {
+        if (cpu)
+        {
+            if (cpu->kernel)
+                cpu->dispatch(glm::uvec3(groupsX, groupsY, groupsZ));
+            return;
+        }
+        glDispatchCompute(groupsX, groupsY, groupsZ);
+    }
+    // run enough workgroups to cover width x height x depth invocations. The
+    // kernel receives the size as dispatchExtent and returns early past it,
+    // so any resolution works whatever the local size
+    // ------------------------------------------------------------------------
+    void dispatchFor(GLuint width, GLuint height, GLuint depth = 1) const
+    {
+        setVec3I(extentUniform, (int)width, (int)height, (int)depth);
+        glm::uvec3 groups = groupsFor(width, height, depth);
+        dispatch(groups.x, groups.y, groups.z);
+    }
+    ComputeBackend backend() const
+    {
+        return cpu ? ComputeBackend::CPU : ComputeBackend::GL;
+    }
+    // local_size the program was built with
+    // ------------------------------------------------------------------------
+    glm::uvec3 localSize() const
+    {
+        if (cpu)
+        {
+            if (cpu->localSize.x) return cpu->localSize;
+            return cpu->kernel ? cpu->kernel->localSize() : glm::uvec3(1);
+        }
+        return local;
+    }
+    // workgroups that cover width x height x depth invocations, rounded up
+    // ------------------------------------------------------------------------
+    glm::uvec3 groupsFor(GLuint width, GLuint height, GLuint depth = 1) const
+    {
+        glm::uvec3 size = localSize();
+        return (glm::uvec3(width, height, depth) + size - 1u) / size;
+    }
+    // CPU backend only: what glBindImageTexture / glBindBufferBase do for GL
+    // ------------------------------------------------------------------------
+    void bindImage(GLuint unit, CpuImage* image) const
+    {
+        if (cpu && unit < CpuBindings::MAX_BINDINGS)
+            cpu->bindings.images[unit] = image;
+    }
+    void bindBuffer(GLuint binding, const void* data, size_t size) const
+    {
+        if (cpu && binding < CpuBindings::MAX_BINDINGS)
+        {
+            cpu->bindings.buffers[binding] = data;
+            cpu->bindings.bufferSizes[binding] = size;
+        }
+    }
+    void bindUniformBuffer(GLuint binding, const void* block) const
+    {
+        if (cpu && binding < CpuBindings::MAX_BINDINGS)
+            cpu->bindings.uniformBuffers[binding] = block;
+    }
     // utility uniform functions
     // ------------------------------------------------------------------------
+    // resolve a uniform once, for the overloads that take a UniformHandle
+    UniformHandle uniform(const std::string &name) const
+    {
+        if (cpu) return UniformHandle{ cpu->uniforms.slot(name) };
+        return UniformHandle{ uniforms.location(name) };
+    }
+    // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
-    {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    {
+        setBool(uniform(name), value);
+    }
+    void setBool(UniformHandle uniform, bool value) const
+    {
+        if (cpu) { int v = (int)value; cpu->uniforms.setInts(uniform.location, &v, 1); return; }
+        glUniform1i(uniform.location, (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
-    { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    {
+        setInt(uniform(name), value);
+    }
+    void setInt(UniformHandle uniform, int value) const
+    {
+        if (cpu) { cpu->uniforms.setInts(uniform.location, &value, 1); return; }
+        glUniform1i(uniform.location, value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
-    { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    {
+        setFloat(uniform(name), value);
+    }
+    void setFloat(UniformHandle uniform, float value) const
+    {
+        if (cpu) { cpu->uniforms.setFloats(uniform.location, &value, 1); return; }
+        glUniform1f(uniform.location, value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
-    { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    {
+        setVec2(uniform(name), value);
+    }
+    void setVec2(UniformHandle uniform, const glm::vec2 &value) const
+    {
+        if (cpu) { cpu->uniforms.setFloats(uniform.location, &value[0], 2); return; }
+        glUniform2fv(uniform.location, 1, &value[0]);
     }
     void setVec2(const std::string &name, float x, float y) const
-    { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+    {
+        setVec2(uniform(name), x, y);
+    }
+    void setVec2(UniformHandle uniform, float x, float y) const
+    {
+        if (cpu) { float v[] = { x, y }; cpu->uniforms.setFloats(uniform.location, v, 2); return; }
+        glUniform2f(uniform.location, x, y);
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
-    { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    {
+        setVec3(uniform(name), value);
+    }
+    void setVec3(UniformHandle uniform, const glm::vec3 &value) const
+    {
+        if (cpu) { cpu->uniforms.setFloats(uniform.location, &value[0], 3); return; }
+        glUniform3fv(uniform.location, 1, &value[0]);
     }
     void setVec3(const std::string &name, float x, float y, float z) const
-    { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+    {
+        setVec3(uniform(name), x, y, z);
+    }
+    void setVec3(UniformHandle uniform, float x, float y, float z) const
+    {
+        if (cpu) { float v[] = { x, y, z }; cpu->uniforms.setFloats(uniform.location, v, 3); return; }
+        glUniform3f(uniform.location, x, y, z);
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
-    { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    {
+        setVec4(uniform(name), value);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
-    { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+    void setVec4(UniformHandle uniform, const glm::vec4 &value) const
+    {
+        if (cpu) { cpu->uniforms.setFloats(uniform.location, &value[0], 4); return; }
+        glUniform4fv(uniform.location, 1, &value[0]);
+    }
+    void setVec4(const std::string &name, float x, float y, float z, float w) const
+    {
+        setVec4(uniform(name), x, y, z, w);
+    }
+    void setVec4(UniformHandle uniform, float x, float y, float z, float w) const
+    {
+        if (cpu) { float v[] = { x, y, z, w }; cpu->uniforms.setFloats(uniform.location, v, 4); return; }
+        glUniform4f(uniform.location, x, y, z, w);
     }
     // ------------------------------------------------------------------------
     void setVec2I(const std::string &name, const glm::vec2 &value) const
-    { 
-        glUniform2i(glGetUniformLocation(ID, name.c_str()), value[0], value[1]); 
+    {
+        setVec2I(uniform(name), value);
+    }
+    void setVec2I(UniformHandle uniform, const glm::vec2 &value) const
+    {
+        if (cpu) { int v[] = { (int)value[0], (int)value[1] }; cpu->uniforms.setInts(uniform.location, v, 2); return; }
+        glUniform2i(uniform.location, value[0], value[1]);
     }
     void setVec2I(const std::string &name, int x, int y) const
-    { 
-        glUniform2i(glGetUniformLocation(ID, name.c_str()), x, y); 
+    {
+        setVec2I(uniform(name), x, y);
+    }
+    void setVec2I(UniformHandle uniform, int x, int y) const
+    {
+        if (cpu) { int v[] = { x, y }; cpu->uniforms.setInts(uniform.location, v, 2); return; }
+        glUniform2i(uniform.location, x, y);
     }
     // ------------------------------------------------------------------------
     void setVec3I(const std::string &name, const glm::vec3 &value) const
-    { 
-        glUniform3i(glGetUniformLocation(ID, name.c_str()), value[0], value[1], value[2]); 
+    {
+        setVec3I(uniform(name), value);
+    }
+    void setVec3I(UniformHandle uniform, const glm::vec3 &value) const
+    {
+        if (cpu) { int v[] = { (int)value[0], (int)value[1], (int)value[2] }; cpu->uniforms.setInts(uniform.location, v, 3); return; }
+        glUniform3i(uniform.location, value[0], value[1], value[2]);
     }
     void setVec3I(const std::string &name, int x, int y, int z) const
-    { 
-        glUniform3i(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+    {
+        setVec3I(uniform(name), x, y, z);
+    }
+    void setVec3I(UniformHandle uniform, int x, int y, int z) const
+    {
+        if (cpu) { int v[] = { x, y, z }; cpu->uniforms.setInts(uniform.location, v, 3); return; }
+        glUniform3i(uniform.location, x, y, z);
     }
     // ------------------------------------------------------------------------
     void setVec4I(const std::string &name, const glm::vec4 &value) const
-    { 
-        glUniform4i(glGetUniformLocation(ID, name.c_str()), value[0], value[1], value[3], value[4]); 
+    {
+        setVec4I(uniform(name), value);
     }
-    void setVec4I(const std::string &name, int x, int y, int z, int w) 
-    { 
-        glUniform4i(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+    void setVec4I(UniformHandle uniform, const glm::vec4 &value) const
+    {
+        if (cpu) { int v[] = { (int)value[0], (int)value[1], (int)value[2], (int)value[3] }; cpu->uniforms.setInts(uniform.location, v, 4); return; }
+        glUniform4i(uniform.location, value[0], value[1], value[2], value[3]);
+    }
+    void setVec4I(const std::string &name, int x, int y, int z, int w) const
+    {
+        setVec4I(uniform(name), x, y, z, w);
+    }
+    void setVec4I(UniformHandle uniform, int x, int y, int z, int w) const
+    {
+        if (cpu) { int v[] = { x, y, z, w }; cpu->uniforms.setInts(uniform.location, v, 4); return; }
+        glUniform4i(uniform.location, x, y, z, w);
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat2(uniform(name), mat);
+    }
+    void setMat2(UniformHandle uniform, const glm::mat2 &mat) const
+    {
+        if (cpu) { cpu->uniforms.setFloats(uniform.location, &mat[0][0], 4); return; }
+        glUniformMatrix2fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(uniform(name), mat);
+    }
+    void setMat3(UniformHandle uniform, const glm::mat3 &mat) const
+    {
+        if (cpu) { cpu->uniforms.setFloats(uniform.location, &mat[0][0], 9); return; }
+        glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat4(uniform(name), mat);
+    }
+    void setMat4(UniformHandle uniform, const glm::mat4 &mat) const
+    {
+        if (cpu) { cpu->uniforms.setFloats(uniform.location, &mat[0][0], 16); return; }
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
-    // utility function for checking shader compilation/linking errors.
-    // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    // set only for ComputeBackend::CPU; shared so copies keep the same program
+    std::shared_ptr<CpuProgram> cpu;
+    UniformCache uniforms;
+    // rebuild started by reload(), with the same prelude
+    ProgramFuture pending;
+    std::string defines;
+    glm::uvec3 local = glm::uvec3(1);
+    UniformHandle extentUniform;
+
+    static glm::uvec3 queryLocalSize(GLuint program)
     {
-        GLint success;
-        GLchar infoLog[1024];
-        if(type != "PROGRAM")
-        {
-            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-            if(!success)
-            {
-                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-            }
-        }
-        else
-        {
-            glGetProgramiv(shader, GL_LINK_STATUS, &success);
-            if(!success)
-            {
-                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-            }
-        }
+        GLint size[3] = { 1, 1, 1 };
+        if (program) glGetProgramiv(program, GL_COMPUTE_WORK_GROUP_SIZE, size);
+        return glm::uvec3(size[0], size[1], size[2]);
     }
 };
 #endif
\ No newline at end of file
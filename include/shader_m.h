@@ -9,6 +9,9 @@
 #include <sstream>
 #include <iostream>
 
+#include "uniform_cache.h"
+#include "program_builder.h"
+
 class Shader {
 public:
     unsigned int ID;
@@ -88,6 +91,7 @@ public:
             glAttachShader(ID, geometry);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        uniforms.build(ID);
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -95,6 +99,13 @@ public:
             glDeleteShader(geometry);
 
     }
+    // adopt a program submitted earlier with ProgramBuilder::graphics(); waits if it is not ready yet
+    // ------------------------------------------------------------------------
+    Shader(ProgramFuture program)
+    {
+        ID = program.get();
+        uniforms.build(ID);
+    }
     // activate the shader
     // ------------------------------------------------------------------------
     void use() 
@@ -103,64 +114,120 @@ public:
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
+    // resolve a uniform once, for the overloads that take a UniformHandle
+    UniformHandle uniform(const std::string &name) const
+    {
+        return UniformHandle{ uniforms.location(name) };
+    }
+    // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
-    {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    {
+        setBool(uniform(name), value);
+    }
+    void setBool(UniformHandle uniform, bool value) const
+    {
+        glUniform1i(uniform.location, (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
-    { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    {
+        setInt(uniform(name), value);
+    }
+    void setInt(UniformHandle uniform, int value) const
+    {
+        glUniform1i(uniform.location, value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
-    { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    {
+        setFloat(uniform(name), value);
+    }
+    void setFloat(UniformHandle uniform, float value) const
+    {
+        glUniform1f(uniform.location, value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
-    { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    {
+        setVec2(uniform(name), value);
+    }
+    void setVec2(UniformHandle uniform, const glm::vec2 &value) const
+    {
+        glUniform2fv(uniform.location, 1, &value[0]);
     }
     void setVec2(const std::string &name, float x, float y) const
-    { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+    {
+        setVec2(uniform(name), x, y);
+    }
+    void setVec2(UniformHandle uniform, float x, float y) const
+    {
+        glUniform2f(uniform.location, x, y);
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
-    { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    {
+        setVec3(uniform(name), value);
+    }
+    void setVec3(UniformHandle uniform, const glm::vec3 &value) const
+    {
+        glUniform3fv(uniform.location, 1, &value[0]);
     }
     void setVec3(const std::string &name, float x, float y, float z) const
-    { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+    {
+        setVec3(uniform(name), x, y, z);
+    }
+    void setVec3(UniformHandle uniform, float x, float y, float z) const
+    {
+        glUniform3f(uniform.location, x, y, z);
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
-    { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    {
+        setVec4(uniform(name), value);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
-    { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+    void setVec4(UniformHandle uniform, const glm::vec4 &value) const
+    {
+        glUniform4fv(uniform.location, 1, &value[0]);
+    }
+    void setVec4(const std::string &name, float x, float y, float z, float w) const
+    {
+        setVec4(uniform(name), x, y, z, w);
+    }
+    void setVec4(UniformHandle uniform, float x, float y, float z, float w) const
+    {
+        glUniform4f(uniform.location, x, y, z, w);
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat2(uniform(name), mat);
+    }
+    void setMat2(UniformHandle uniform, const glm::mat2 &mat) const
+    {
+        glUniformMatrix2fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(uniform(name), mat);
+    }
+    void setMat3(UniformHandle uniform, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat4(uniform(name), mat);
+    }
+    void setMat4(UniformHandle uniform, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    UniformCache uniforms;
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,46 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <string>
+#include <vector>
+
+// Reports edits to shader files, for hot reload. On Linux it uses inotify on
+// the directories of the files, so editors that save by writing a new file
+// and renaming it over the old one are seen too. Elsewhere create() returns
+// false and poll() never reports anything.
+//
+//   watcher.create({ ShaderWatcher::sourcePath("computeSh_test6.cs") });
+//   for (const std::string& path : watcher.poll())    // once per frame, never blocks
+//       computeShader.reload(path.c_str());
+class ShaderWatcher
+{
+public:
+    ShaderWatcher() = default;
+    ~ShaderWatcher() { release(); }
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    bool create(const std::vector<std::string>& files);
+    void release();
+
+    // paths of the watched files changed since the last call, each once
+    std::vector<std::string> poll();
+
+    // SHADER_FILES from CMakeLists.txt: the files in the source tree, not the
+    // copies next to the executable
+    static std::vector<std::string> sourceFiles();
+    // the entry of sourceFiles() with this file name, or the name itself
+    static std::string sourcePath(const std::string& name);
+
+private:
+    struct Watch {
+        int descriptor;
+        std::string directory;
+    };
+
+    int fd = -1;
+    std::vector<Watch> watches;
+    std::vector<std::string> files;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef SPHERE_SCENE_H
+#define SPHERE_SCENE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// std::allocator replacement that hands out Alignment-byte aligned storage,
+// so SIMD kernels can use aligned loads on the scene arrays
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator
+{
+    typedef T value_type;
+    template <typename U> struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, std::size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U> bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+typedef std::vector<float, AlignedAllocator<float, 64>> AlignedFloats;
+
+// Read-only structure-of-arrays view used by the CPU tracers
+struct SphereSceneView
+{
+    const float* centerX;
+    const float* centerY;
+    const float* centerZ;
+    const float* radius;
+    int count;
+
+    glm::vec3 center(int i) const { return glm::vec3(centerX[i], centerY[i], centerZ[i]); }
+    glm::vec4 sphere(int i) const { return glm::vec4(centerX[i], centerY[i], centerZ[i], radius[i]); }
+};
+
+// Sphere list shared by the CPU (test7) and compute shader (test6) renderers.
+// Centers and radii live in separate aligned arrays; upload() mirrors them to
+// two std430 SSBOs:
+//   layout(std430, binding = 1) readonly buffer SphereCenters { vec4 centers[]; };
+//   layout(std430, binding = 2) readonly buffer SphereRadii   { float radii[];  };
+class SphereScene
+{
+public:
+    static const GLuint CENTERS_BINDING = 1;
+    static const GLuint RADII_BINDING = 2;
+
+    // the GL buffers have a single owner: move only, the source is left
+    // without buffers
+    SphereScene() = default;
+    SphereScene(const SphereScene&) = delete;
+    SphereScene& operator=(const SphereScene&) = delete;
+    SphereScene(SphereScene&& other) noexcept;
+    SphereScene& operator=(SphereScene&& other) noexcept;
+
+    void add(const glm::vec3& center, float radius);
+    void add(const glm::vec4& sphere) { add(glm::vec3(sphere), sphere.w); }
+    void set(int i, const glm::vec4& sphere);
+    void reserve(int count);
+    void clear();
+
+    int size() const { return (int)radius.size(); }
+    glm::vec4 get(int i) const { return glm::vec4(centerX[i], centerY[i], centerZ[i], radius[i]); }
+    SphereSceneView view() const;
+
+    // the three spheres the demos were written around
+    static SphereScene defaultScene();
+    // count spheres scattered over a box that grows with the count
+    static SphereScene random(int count, unsigned int seed = 1234);
+
+    // create/refresh the SSBOs with the current contents and bind them
+    void upload();
+    void bind() const;
+    // delete the GL buffers; call while the context is still alive
+    void release();
+
+private:
+    AlignedFloats centerX, centerY, centerZ, radius;
+
+    GLuint centersBuffer = 0;
+    GLuint radiiBuffer = 0;
+    int gpuCapacity = 0;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool of worker threads. Every worker owns a task deque: it pops
+// its own work from the back and, when it runs dry, steals from the front of
+// the other workers' deques, so uneven tiles/workgroups balance themselves.
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // threadCount == 0 means one worker per hardware thread
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int size() const { return (unsigned int)workers.size(); }
+
+    // queue a fire-and-forget task
+    void submit(Task task);
+    // run fn(i) for every i in [0, count) and block until all of them finished.
+    // The calling thread helps draining the queues while it waits.
+    void parallelFor(int count, const std::function<void(int)>& fn);
+
+    // process-wide pool shared by the CPU renderers
+    static ThreadPool& global();
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void workerLoop(unsigned int index);
+    bool popLocal(unsigned int index, Task& task);
+    bool steal(unsigned int thief, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    std::atomic<int> queued{0};
+    std::atomic<unsigned int> nextQueue{0};
+    bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef TILE_RENDERER_H
+#define TILE_RENDERER_H
+
+#include "thread_pool.h"
+#include "pixel_order.h"
+
+#include <algorithm>
+
+// 32x32 RGBA8 pixels = 4 KB of output per tile, small enough that a tile's
+// writes and its working set stay in L1 while it is being shaded
+const int DEFAULT_TILE_SIZE = 32;
+// side of the square ray packets of PixelOrder::Morton; 8x8 = 64 rays
+const int PACKET_BLOCK_SIZE = 8;
+
+struct Tile
+{
+    int x0, y0; // inclusive
+    int x1, y1; // exclusive
+};
+
+// Split a width x height frame into square tiles and shade them on the pool.
+// fn(const Tile&) is called once per tile, from any worker thread. The pool
+// hands tiles out in order: Morton keeps the tiles in flight on the threads
+// next to each other instead of spread along a row of tiles.
+template <typename F>
+void renderTiles(ThreadPool& pool, int width, int height, int tileSize, F&& fn,
+                 PixelOrder order = PixelOrder::RowMajor)
+{
+    int tilesX = (width + tileSize - 1) / tileSize;
+    int tilesY = (height + tileSize - 1) / tileSize;
+
+    pool.parallelFor(tilesX * tilesY, [&](int index) {
+        glm::uvec2 cell = order == PixelOrder::Morton
+            ? mortonCell((uint32_t)index, glm::uvec2(tilesX, tilesY))
+            : glm::uvec2(index % tilesX, index / tilesX);
+        Tile tile;
+        tile.x0 = (int)cell.x * tileSize;
+        tile.y0 = (int)cell.y * tileSize;
+        tile.x1 = std::min(tile.x0 + tileSize, width);
+        tile.y1 = std::min(tile.y0 + tileSize, height);
+        fn(tile);
+    });
+}
+
+// Pieces of a tile traced as one ray packet, lanes row by row inside each:
+// the tile's rows (RowMajor) or PACKET_BLOCK_SIZE squares (Morton), along a
+// Z curve in whole tiles; their rays stay closer together and share more BVH
+// nodes.
+// fn(const Tile&) is called in order on the calling thread.
+template <typename F>
+void forEachPacket(const Tile& tile, PixelOrder order, F&& fn)
+{
+    if (order == PixelOrder::RowMajor) {
+        for (int y = tile.y0; y < tile.y1; ++y)
+            fn(Tile{ tile.x0, y, tile.x1, y + 1 });
+        return;
+    }
+    int blocksX = (tile.x1 - tile.x0 + PACKET_BLOCK_SIZE - 1) / PACKET_BLOCK_SIZE;
+    int blocksY = (tile.y1 - tile.y0 + PACKET_BLOCK_SIZE - 1) / PACKET_BLOCK_SIZE;
+    for (int index = 0; index < blocksX * blocksY; ++index) {
+        glm::uvec2 cell = mortonLocal((uint32_t)index, glm::uvec2(blocksX, blocksY));
+        Tile block;
+        block.x0 = tile.x0 + (int)cell.x * PACKET_BLOCK_SIZE;
+        block.y0 = tile.y0 + (int)cell.y * PACKET_BLOCK_SIZE;
+        block.x1 = std::min(block.x0 + PACKET_BLOCK_SIZE, tile.x1);
+        block.y1 = std::min(block.y0 + PACKET_BLOCK_SIZE, tile.y1);
+        fn(block);
+    }
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef UNIFORM_CACHE_H
+#define UNIFORM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <unordered_map>
+
+// Pre-resolved uniform, from Shader::uniform() / ComputeShader::uniform().
+// Passing it to the set* overloads skips the name lookup entirely.
+struct UniformHandle
+{
+    GLint location = -1;
+
+    bool valid() const { return location >= 0; }
+};
+
+// Name -> location table of a linked program. build() walks the active
+// uniforms once through program interface introspection; names it does not
+// list (e.g. "arr[3]") are asked to the driver on first use and kept too.
+class UniformCache
+{
+public:
+    void build(GLuint program)
+    {
+        this->program = program;
+        locations.clear();
+
+        GLint count = 0, maxLength = 0;
+        glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+        glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxLength);
+        locations.reserve(count);
+
+        std::string name(maxLength, '\0');
+        const GLenum props[] = { GL_LOCATION };
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            glGetProgramResourceName(program, GL_UNIFORM, i, maxLength, &length, &name[0]);
+            GLint location = -1;
+            glGetProgramResourceiv(program, GL_UNIFORM, i, 1, props, 1, nullptr, &location);
+            // members of uniform blocks have no location
+            if (location < 0)
+                continue;
+
+            std::string key(name.data(), length);
+            locations[key] = location;
+            // arrays are listed as "arr[0]" but glGetUniformLocation also takes "arr"
+            if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0)
+                locations[key.substr(0, key.size() - 3)] = location;
+        }
+    }
+
+    GLint location(const std::string& name) const
+    {
+        auto it = locations.find(name);
+        if (it != locations.end())
+            return it->second;
+        GLint location = glGetUniformLocation(program, name.c_str());
+        locations.emplace(name, location);
+        return location;
+    }
+
+private:
+    GLuint program = 0;
+    mutable std::unordered_map<std::string, GLint> locations;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef UNIFORM_RING_H
+#define UNIFORM_RING_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+// Ring of uniform blocks in a single buffer, for parameters that change on
+// every dispatch. write() copies a block into the next free slot and binds
+// just that slot with glBindBufferRange, so several dispatches in one frame
+// each keep their own values.
+//
+// The buffer holds framesInFlight regions of slotsPerFrame slots. With
+// ARB_buffer_storage it is mapped once (persistent + coherent) and a write is
+// a memcpy; a fence per region keeps the CPU from overwriting slots the GPU
+// may still read. Without it every write goes through glBufferSubData.
+class UniformRing
+{
+public:
+    static const int DEFAULT_SLOTS_PER_FRAME = 16;
+    static const int DEFAULT_FRAMES_IN_FLIGHT = 3;
+
+    void create(GLuint binding, size_t blockSize, int slotsPerFrame = DEFAULT_SLOTS_PER_FRAME,
+                int framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
+    // copy blockSize bytes into the next slot and bind it to the binding point
+    void write(const void* block);
+    // fence the slots used this frame; call after the frame's last dispatch
+    void endFrame();
+    void release();
+
+    bool isPersistent() const { return mapped != nullptr; }
+    GLuint getBuffer() const { return buffer; }
+
+private:
+    void waitRegion(int r);
+
+    GLuint buffer = 0;
+    GLuint binding = 0;
+    size_t blockSize = 0;
+    size_t stride = 0;
+    int slotsPerFrame = 0;
+    int framesInFlight = 0;
+    int region = 0;
+    int slot = 0;
+    unsigned char* mapped = nullptr;
+    std::vector<GLsync> fences;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef WORKGROUP_SIZE_H
+#define WORKGROUP_SIZE_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+
+// local_size of a compute kernel chosen at run time. The .cs files take it
+// from LOCAL_SIZE_X / LOCAL_SIZE_Y when they are defined, so it reaches the
+// GLSL as a #define prelude (see ProgramBuilder::compute).
+struct WorkgroupSize
+{
+    glm::uvec3 local = glm::uvec3(0);    // 0: keep the size written in the shader
+
+    WorkgroupSize() = default;
+    explicit WorkgroupSize(const glm::uvec3& local) : local(local) {}
+
+    bool isDefault() const { return local.x == 0; }
+
+    // "#define LOCAL_SIZE_X 16\n#define LOCAL_SIZE_Y 8\n", empty for the default
+    std::string defines() const
+    {
+        if (isDefault())
+            return "";
+        return "#define LOCAL_SIZE_X " + std::to_string(local.x) + "\n"
+             + "#define LOCAL_SIZE_Y " + std::to_string(local.y) + "\n";
+    }
+};
+
+#endif
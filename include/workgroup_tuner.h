@@ -0,0 +1,73 @@
+#ifndef WORKGROUP_TUNER_H
+#define WORKGROUP_TUNER_H
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "shader_c.h"
+#include "workgroup_size.h"
+
+// Picks local_size for a compute kernel by timing it. Every candidate is
+// built with a LOCAL_SIZE_X/Y prelude (all submitted at once, so the driver
+// compiles them in parallel), dispatched over the same domain and timed with
+// GL_TIMESTAMP queries (wall clock after glFinish when the driver stamps
+// at submission instead). The fastest one is kept in a table on disk, one
+// line per kernel file name and device, which applications read at startup
+// with WorkgroupTuner::saved().
+//
+// With ComputeBackend::CPU the candidates run on the C++ ports and are timed
+// with a steady clock, under the device name "CPU (N threads)". The same
+// candidate / timing / table logic runs without any GL context.
+class WorkgroupTuner
+{
+public:
+    static const int DEFAULT_REPEATS = 20;
+    static const int WARMUP_DISPATCHES = 3;
+    static const char* const DEFAULT_TABLE;
+
+    struct Result {
+        glm::uvec3 local;
+        double ms;    // per dispatch
+    };
+
+    explicit WorkgroupTuner(ComputeBackend backend = ComputeBackend::GL, const std::string& table = DEFAULT_TABLE);
+
+    // 2D sizes from 8x8 to 32x32 plus a few rows, limited to what the device accepts
+    std::vector<glm::uvec3> defaultCandidates() const;
+    void setCandidates(const std::vector<glm::uvec3>& candidates) { this->candidates = candidates; }
+    void setRepeats(int repeats) { this->repeats = repeats < 1 ? 1 : repeats; }
+    // other #defines every candidate is built with, e.g. OutputImage::defines()
+    void setDefines(const std::string& defines) { this->defines = defines; }
+
+    // times every candidate over width x height invocations and saves the
+    // fastest. setup binds images/buffers and sets uniforms on each candidate
+    // program; bindings made through the GL context carry over by themselves
+    WorkgroupSize tune(const char* computePath, unsigned width, unsigned height,
+                       const std::function<void(ComputeShader&)>& setup);
+    // timings of the last tune(), in candidate order
+    const std::vector<Result>& results() const { return lastResults; }
+
+    // size saved for this kernel on this device; the default (shader's own) if none
+    WorkgroupSize saved(const char* computePath) const;
+    static WorkgroupSize saved(const char* computePath, ComputeBackend backend) {
+        return WorkgroupTuner(backend).saved(computePath);
+    }
+
+    std::string deviceName() const;
+
+private:
+    double time(ComputeShader& shader, unsigned width, unsigned height) const;
+    void save(const std::string& kernel, const glm::uvec3& local) const;
+
+    ComputeBackend backend;
+    std::string table;
+    std::vector<glm::uvec3> candidates;
+    std::string defines;
+    int repeats = DEFAULT_REPEATS;
+    std::vector<Result> lastResults;
+};
+
+#endif
@@ -7,6 +7,10 @@
 #include "camera3.h"
 #include "shader_m.h"
 #include "shader_c.h"
+#include "app_context.h"
+#include "gpu_profiler.h"
+#include "workgroup_tuner.h"
+#include "output_image.h"
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -14,6 +18,11 @@ const unsigned int SCR_HEIGHT = 600;
 
 // texture size
 const unsigned int TEXTURE_WIDTH = 1000, TEXTURE_HEIGHT = 1000;
+// the gradient has two channels in 0..1, 8 bits each are enough (RGBA32F took 4x the memory)
+const ImageFormat IMAGE_FORMAT = ImageFormat::RGBA8;
+
+// frames between GPU time reports
+const int PROFILE_REPORT_FRAMES = 120;
 
 // timing 
 double deltaTime = 0.0f; // time between current frame and last frame
@@ -22,47 +31,24 @@ double lastFrame = 0.0f; // time of last frame
 void renderQuad();
 
 int main(int argc, char* argv[]) {
-    // Initialize SDL2
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "Failed to initialize SDL2: " << SDL_GetError() << std::endl;
-        return -1;
-    }
-
-    // Configure OpenGL attributes
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-
-    // Create SDL2 window
-    SDL_Window* window = SDL_CreateWindow("Compute Shader Demo", 
-                                          SCR_WIDTH, SCR_HEIGHT, 
-                                          SDL_WINDOW_OPENGL);
-    if (!window) {
-        std::cerr << "Failed to create SDL2 window: " << SDL_GetError() << std::endl;
-        SDL_Quit();
-        return -1;
-    }
-
-    // Create OpenGL context
-    SDL_GLContext glContext = SDL_GL_CreateContext(window);
-    if (!glContext) {
-        std::cerr << "Failed to create OpenGL context: " << SDL_GetError() << std::endl;
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        return -1;
-    }
+    // --headless [--frames N] [--output frame.ppm]: no window, EGL context
+    RunOptions options = RunOptions::parse(argc, argv);
 
-    // Load OpenGL functions using GLAD
-    if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        SDL_GL_DestroyContext(glContext);
-        SDL_DestroyWindow(window);
-        SDL_Quit();
+    // Create the SDL window and the OpenGL 4.3 context, load GL with GLAD
+    AppContext app;
+    if (!app.create("Compute Shader Demo", SCR_WIDTH, SCR_HEIGHT, options)) {
         return -1;
     }
 
     // Enable V-Sync
-    SDL_GL_SetSwapInterval(0);
+    if (!app.isHeadless())
+        SDL_GL_SetSwapInterval(0);
+
+    // Submit the shader builds now; the driver compiles them while the rest is set up
+    ProgramFuture quadProgram = ProgramBuilder::graphics("screenQuad.vs", "screenQuad.fs");
+    // local_size picked by tune_workgroups for this device, if it was run
+    WorkgroupSize workgroupSize = WorkgroupTuner::saved("computeShader.cs", ComputeBackend::GL);
+    ProgramFuture computeProgram = ProgramBuilder::compute("computeShader.cs", workgroupSize.defines() + imageFormatDefines(IMAGE_FORMAT));
 
     // Print OpenGL version
     std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
@@ -82,25 +68,24 @@ int main(int argc, char* argv[]) {
     std::cout << "maximum number of work groups in X dimension " << max_compute_work_group_count[0] << std::endl;
     std::cout << "maximum size of a work group in X dimension " << max_compute_work_group_size[0] << std::endl;
 
-    // Build and compile shaders
-    Shader screenQuad("screenQuad.vs", "screenQuad.fs");
-    ComputeShader computeShader("computeShader.cs");
+    // Create the output image; it stays bound to texture unit 0 for the screen quad
+    glActiveTexture(GL_TEXTURE0);
+    OutputImage image;
+    image.create(TEXTURE_WIDTH, TEXTURE_HEIGHT, IMAGE_FORMAT, GL_LINEAR);
+    image.bindImage(0);
+    std::cout << "Output image " << imageFormatInfo(IMAGE_FORMAT).name << ": " << image.bytes() / (1024.0 * 1024.0) << " MB" << std::endl;
+    printImageFootprint(std::cout, TEXTURE_WIDTH, TEXTURE_HEIGHT);
+
+    // Take the shaders built in the meantime (waits only if they are still compiling)
+    Shader screenQuad(quadProgram);
+    ComputeShader computeShader(computeProgram);
 
     screenQuad.use();
     screenQuad.setInt("tex", 0);
 
-    // Create texture for OpenGL operations
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, TEXTURE_WIDTH, TEXTURE_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-
-    glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+    // Per-stage GPU time, read back two frames late so it never stalls
+    GpuProfiler profiler;
+    profiler.create();
 
     // Render loop
     bool running = true;
@@ -108,7 +93,7 @@ int main(int argc, char* argv[]) {
     int fCounter = 0;
 	double elapsedTime = 0.0;
 
-    while (running) {
+    while (running && app.nextFrame()) {
         static uint64_t frequency = SDL_GetPerformanceFrequency();
 		uint64_t currentFrame = SDL_GetPerformanceCounter();
 		deltaTime = static_cast<double>(currentFrame - lastFrame) / frequency;
@@ -129,25 +114,36 @@ int main(int argc, char* argv[]) {
             }
         }
 
-        computeShader.use();
-        computeShader.setFloat("t", elapsedTime);
-        glDispatchCompute((unsigned int)TEXTURE_WIDTH / 10, (unsigned int)TEXTURE_HEIGHT / 10, 1);
-        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        screenQuad.use();
-        renderQuad();
+        profiler.beginFrame();
+        {
+            GpuScope scope(profiler, "dispatch");
+            computeShader.use();
+            computeShader.setFloat("t", elapsedTime);
+            computeShader.dispatchFor(TEXTURE_WIDTH, TEXTURE_HEIGHT);
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        }
+        {
+            GpuScope scope(profiler, "quad");
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            screenQuad.use();
+            renderQuad();
+        }
+        profiler.endFrame();
+        if (app.getFrame() % PROFILE_REPORT_FRAMES == 0)
+            profiler.print(std::cout);
 
-        SDL_GL_SwapWindow(window);
+        app.swap();
     }
 
+    if (!options.output.empty() && !saveTexturePPM(options.output, image.texture(), TEXTURE_WIDTH, TEXTURE_HEIGHT))
+        std::cerr << "Failed to write " << options.output << std::endl;
+
     // Cleanup
-    glDeleteTextures(1, &texture);
+    profiler.release();
+    image.release();
     glDeleteProgram(screenQuad.ID);
     glDeleteProgram(computeShader.ID);
-    SDL_GL_DestroyContext(glContext);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    app.destroy();
 
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,100 @@
+#version 430
+// Una pasada del radix sort LSD de GpuRadixSort (include/compute_primitives.h):
+// mueve cada clave y su valor a su posición según el dígito
+// (clave >> shift) & (RADIX - 1). offsets es el scan exclusivo de los
+// histogramas por workgroup de histogram.cs (PER_GROUP_BINS), así que
+// offsets[dígito * grupos + grupo] es donde empiezan las claves de ese
+// dígito de este grupo. Dentro del grupo el orden se mantiene: el sort es
+// estable y las pasadas se pueden encadenar.
+#ifndef LOCAL_SIZE_X
+#define LOCAL_SIZE_X 256
+#endif
+layout(local_size_x = LOCAL_SIZE_X, local_size_y = 1, local_size_z = 1) in;
+#ifndef RADIX_BITS
+#define RADIX_BITS 4
+#endif
+const uint RADIX = 1u << RADIX_BITS;
+
+layout(std430, binding = 0) readonly buffer KeysIn { uint keysIn[]; };
+layout(std430, binding = 1) readonly buffer ValuesIn { uint valuesIn[]; };
+layout(std430, binding = 2) writeonly buffer KeysOut { uint keysOut[]; };
+layout(std430, binding = 3) writeonly buffer ValuesOut { uint valuesOut[]; };
+layout(std430, binding = 4) readonly buffer Offsets { uint offsets[]; };
+uniform int count;
+uniform int shift;
+
+// igual que ELEMENTS_PER_GROUP de histogram.cs; LOCAL_SIZE_X potencia de dos
+const uint ITEMS_PER_INVOCATION = 16u;
+const uint PARTITION_SIZE = LOCAL_SIZE_X * ITEMS_PER_INVOCATION;
+
+// cuántas claves de cada dígito tiene cada invocación, [dígito][invocación];
+// tras el scan, la posición dentro del grupo de su primera clave con ese dígito
+shared uint counts[RADIX * LOCAL_SIZE_X];
+shared uint totals[LOCAL_SIZE_X];
+shared uint digitStart[RADIX];
+
+void main() {
+    uint lid = gl_LocalInvocationID.x;
+    uint group = gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x;
+    uint groupCount = (uint(count) + PARTITION_SIZE - 1u) / PARTITION_SIZE;
+
+    for( uint d=0u; d<RADIX; d++ )
+        counts[d * LOCAL_SIZE_X + lid] = 0u;
+
+    // cada invocación toma ITEMS_PER_INVOCATION claves seguidas, así el orden
+    // de invocación y de elemento es el orden original
+    uint keys[ITEMS_PER_INVOCATION];
+    uint base = group * PARTITION_SIZE + lid * ITEMS_PER_INVOCATION;
+    for( uint i=0u; i<ITEMS_PER_INVOCATION; i++ )
+    {
+        uint index = base + i;
+        keys[i] = index<uint(count) ? keysIn[index] : 0u;
+        if( index<uint(count) ) counts[((keys[i] >> uint(shift)) & (RADIX - 1u)) * LOCAL_SIZE_X + lid]++;
+    }
+    memoryBarrierShared();
+    barrier();
+
+    // scan exclusivo de counts: RADIX entradas seguidas por invocación y
+    // Hillis-Steele sobre los totales de cada invocación
+    uint first = lid * RADIX;
+    uint sum = 0u;
+    for( uint j=0u; j<RADIX; j++ )
+    {
+        uint value = counts[first + j];
+        counts[first + j] = sum;
+        sum += value;
+    }
+    totals[lid] = sum;
+    memoryBarrierShared();
+    barrier();
+    for( uint offset=1u; offset<LOCAL_SIZE_X; offset<<=1u )
+    {
+        uint add = lid>=offset ? totals[lid - offset] : 0u;
+        memoryBarrierShared();
+        barrier();
+        totals[lid] += add;
+        memoryBarrierShared();
+        barrier();
+    }
+    uint invocationPrefix = totals[lid] - sum;
+    for( uint j=0u; j<RADIX; j++ )
+        counts[first + j] += invocationPrefix;
+    memoryBarrierShared();
+    barrier();
+
+    if( lid<RADIX ) digitStart[lid] = counts[lid * LOCAL_SIZE_X];
+    memoryBarrierShared();
+    barrier();
+
+    for( uint i=0u; i<ITEMS_PER_INVOCATION; i++ )
+    {
+        uint index = base + i;
+        if( index>=uint(count) ) break;
+        uint digit = (keys[i] >> uint(shift)) & (RADIX - 1u);
+        // solo esta invocación toca su columna de counts
+        uint rank = counts[digit * LOCAL_SIZE_X + lid]++ - digitStart[digit];
+        uint destination = offsets[digit * groupCount + group] + rank;
+        keysOut[destination] = keys[i];
+        valuesOut[destination] = valuesIn[index];
+    }
+}
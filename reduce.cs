@@ -0,0 +1,74 @@
+#version 430
+// Reducción de un buffer de floats (suma, mínimo o máximo), ver GpuReduce
+// (include/compute_primitives.h). Cada workgroup reduce ELEMENTS_PER_GROUP
+// valores en memoria compartida y deja uno en partials; GpuReduce repite el
+// dispatch sobre partials hasta que queda un solo valor.
+#ifndef LOCAL_SIZE_X
+#define LOCAL_SIZE_X 256
+#endif
+layout(local_size_x = LOCAL_SIZE_X, local_size_y = 1, local_size_z = 1) in;
+// 0 suma, 1 mínimo, 2 máximo
+#ifndef REDUCE_OP
+#define REDUCE_OP 0
+#endif
+
+layout(std430, binding = 0) readonly buffer Input { float values[]; };
+layout(std430, binding = 1) writeonly buffer Partials { float partials[]; };
+uniform int count;
+
+// LOCAL_SIZE_X tiene que ser potencia de dos para el árbol de la reducción
+const uint ITEMS_PER_INVOCATION = 16u;
+const uint ELEMENTS_PER_GROUP = LOCAL_SIZE_X * ITEMS_PER_INVOCATION;
+
+shared float partial[LOCAL_SIZE_X];
+
+float identity()
+{
+#if REDUCE_OP == 1
+    return uintBitsToFloat(0x7f800000u);    // +inf
+#elif REDUCE_OP == 2
+    return uintBitsToFloat(0xff800000u);    // -inf
+#else
+    return 0.0;
+#endif
+}
+
+float combine( float a, float b )
+{
+#if REDUCE_OP == 1
+    return min( a, b );
+#elif REDUCE_OP == 2
+    return max( a, b );
+#else
+    return a + b;
+#endif
+}
+
+void main() {
+    uint lid = gl_LocalInvocationID.x;
+    // los grupos van en 2D cuando no caben en gl_MaxComputeWorkGroupCount.x
+    uint group = gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x;
+
+    // lecturas consecutivas entre invocaciones vecinas
+    float acc = identity();
+    uint base = group * ELEMENTS_PER_GROUP + lid;
+    for( uint i=0u; i<ITEMS_PER_INVOCATION; i++ )
+    {
+        uint index = base + i * LOCAL_SIZE_X;
+        if( index<uint(count) ) acc = combine( acc, values[index] );
+    }
+    partial[lid] = acc;
+    memoryBarrierShared();
+    barrier();
+
+    for( uint stride=LOCAL_SIZE_X/2u; stride>0u; stride>>=1u )
+    {
+        if( lid<stride ) partial[lid] = combine( partial[lid], partial[lid + stride] );
+        memoryBarrierShared();
+        barrier();
+    }
+
+    // el grupo 0 escribe siempre, así un buffer vacío reduce al elemento neutro
+    if( lid==0u && (group==0u || group * ELEMENTS_PER_GROUP<uint(count)) )
+        partials[group] = partial[0];
+}
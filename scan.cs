@@ -0,0 +1,131 @@
+#version 430
+// Prefix sum exclusivo de un buffer de uints en una sola pasada, con
+// decoupled look-back (Merrill y Garland): cada workgroup toma la siguiente
+// partición, publica su total y suma los de las particiones anteriores en
+// cuanto están disponibles, sin esperar a que termine todo el buffer.
+// Ver GpuScan (include/compute_primitives.h).
+#ifndef LOCAL_SIZE_X
+#define LOCAL_SIZE_X 256
+#endif
+layout(local_size_x = LOCAL_SIZE_X, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer Input { uint values[]; };
+layout(std430, binding = 1) writeonly buffer Output { uint result[]; };
+
+// estado de cada partición; GpuScan lo pone a cero antes de cada dispatch
+const uint FLAG_NONE = 0u;
+const uint FLAG_AGGREGATE = 1u;    // total de la partición sola
+const uint FLAG_PREFIX = 2u;       // total desde el principio del buffer hasta ella
+struct PartitionState
+{
+    uint flag;
+    uint aggregate;
+    uint inclusivePrefix;
+    uint padding;
+};
+layout(std430, binding = 2) coherent volatile buffer ScanState
+{
+    uint nextPartition;
+    uint padding0, padding1, padding2;
+    PartitionState partitions[];
+};
+uniform int count;
+uniform int partitionCount;    // particiones que caben en ScanState
+
+// LOCAL_SIZE_X tiene que ser potencia de dos
+const uint ITEMS_PER_INVOCATION = 8u;
+const uint PARTITION_SIZE = LOCAL_SIZE_X * ITEMS_PER_INVOCATION;
+
+shared uint partitionId;
+shared uint sums[LOCAL_SIZE_X];
+shared uint exclusivePrefix;
+
+void publish( uint part, uint flag, uint value )
+{
+    if( flag==FLAG_PREFIX ) partitions[part].inclusivePrefix = value;
+    else partitions[part].aggregate = value;
+    // el valor tiene que ser visible antes que el flag
+    memoryBarrierBuffer();
+    atomicExchange( partitions[part].flag, flag );
+}
+
+void main() {
+    uint lid = gl_LocalInvocationID.x;
+
+    // las particiones se reparten en el orden en que arrancan los grupos, así
+    // las anteriores a la de un grupo ya están en marcha y la espera termina
+    if( lid==0u ) partitionId = atomicAdd( nextPartition, 1u );
+    memoryBarrierShared();
+    barrier();
+    uint part = partitionId;
+    // la rejilla 2D puede tener algún grupo de más (linearGroups); el que saca
+    // una partición fuera de ScanState no publica ni escribe nada. Sin return,
+    // porque detrás vienen barrier()
+    bool inRange = part<uint(partitionCount);
+
+    // cada invocación suma ITEMS_PER_INVOCATION valores seguidos
+    uint prefixes[ITEMS_PER_INVOCATION];
+    uint base = part * PARTITION_SIZE + lid * ITEMS_PER_INVOCATION;
+    uint sum = 0u;
+    for( uint i=0u; i<ITEMS_PER_INVOCATION; i++ )
+    {
+        uint index = base + i;
+        prefixes[i] = sum;
+        sum += index<uint(count) ? values[index] : 0u;
+    }
+
+    // scan inclusivo de los totales de las invocaciones (Hillis-Steele)
+    sums[lid] = sum;
+    memoryBarrierShared();
+    barrier();
+    for( uint offset=1u; offset<LOCAL_SIZE_X; offset<<=1u )
+    {
+        uint add = lid>=offset ? sums[lid - offset] : 0u;
+        memoryBarrierShared();
+        barrier();
+        sums[lid] += add;
+        memoryBarrierShared();
+        barrier();
+    }
+    uint invocationPrefix = sums[lid] - sum;
+
+    // look-back: una sola invocación recorre las particiones anteriores
+    if( lid==0u && inRange )
+    {
+        uint aggregate = sums[LOCAL_SIZE_X - 1u];
+        uint prefix = 0u;
+        if( part==0u )
+        {
+            publish( part, FLAG_PREFIX, aggregate );
+        }
+        else
+        {
+            publish( part, FLAG_AGGREGATE, aggregate );
+            uint previous = part - 1u;
+            while( true )
+            {
+                uint flag = partitions[previous].flag;
+                if( flag==FLAG_NONE ) continue;
+                memoryBarrierBuffer();
+                if( flag==FLAG_PREFIX )
+                {
+                    prefix += partitions[previous].inclusivePrefix;
+                    break;
+                }
+                prefix += partitions[previous].aggregate;
+                previous--;
+            }
+            publish( part, FLAG_PREFIX, prefix + aggregate );
+        }
+        exclusivePrefix = prefix;
+    }
+    memoryBarrierShared();
+    barrier();
+
+    uint offset = exclusivePrefix + invocationPrefix;
+    for( uint i=0u; i<ITEMS_PER_INVOCATION; i++ )
+    {
+        uint index = base + i;
+        if( inRange && index<uint(count) ) result[index] = offset + prefixes[i];
+    }
+}
@@ -4,8 +4,11 @@ layout (location = 1) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 
+// part of the texture holding the image (Presenter with pooled textures)
+uniform vec2 texScale = vec2(1.0);
+
 void main()
 {
-    TexCoords = aTexCoords;
+    TexCoords = aTexCoords * texScale;
     gl_Position = vec4(aPos, 1.0);
 }
\ No newline at end of file
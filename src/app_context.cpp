@@ -0,0 +1,271 @@
+#include "app_context.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef CS_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+RunOptions RunOptions::parse(int& argc, char** argv) {
+    RunOptions options;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--headless") == 0)
+            options.headless = true;
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            options.output = argv[++i];
+        else if (std::strcmp(argv[i], "--present") == 0 && i + 1 < argc)
+            options.present = argv[++i];
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    argv[argc] = nullptr;
+    return options;
+}
+
+bool AppContext::create(const char* title, int width, int height, const RunOptions& options, bool withGL) {
+    this->options = options;
+    this->width = width;
+    this->height = height;
+    frame = 0;
+
+    if (options.headless) {
+        if (!SDL_Init(SDL_INIT_EVENTS)) {
+            std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        if (withGL && !createHeadlessGL(width, height)) {
+            destroy();
+            return false;
+        }
+    }
+    else {
+        if (!SDL_Init(SDL_INIT_VIDEO)) {
+            std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+
+        window = SDL_CreateWindow(title, width, height, SDL_WINDOW_OPENGL);
+        if (!window) {
+            std::cerr << "Failed to create SDL window: " << SDL_GetError() << std::endl;
+            destroy();
+            return false;
+        }
+        if (withGL) {
+            glContext = SDL_GL_CreateContext(window);
+            if (!glContext) {
+                std::cerr << "Failed to create OpenGL context: " << SDL_GetError() << std::endl;
+                destroy();
+                return false;
+            }
+            if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
+                std::cerr << "Failed to initialize GLAD" << std::endl;
+                destroy();
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool AppContext::createHeadlessGL(int width, int height) {
+#ifdef CS_HEADLESS_EGL
+    // Mesa's surfaceless platform needs neither X11 nor a DRM device
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (clientExtensions && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless") && getPlatformDisplay)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::cerr << "Failed to initialize EGL: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+    eglDisplay = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL has no desktop OpenGL" << std::endl;
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    bool pbuffer = eglChooseConfig(display, configAttribs, &config, 1, &configCount) && configCount > 0;
+    if (!pbuffer) {
+        // no pbuffer configs: any GL config, rendered surfaceless
+        const EGLint anyConfig[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        if (!eglChooseConfig(display, anyConfig, &config, 1, &configCount) || configCount == 0) {
+            std::cerr << "No EGL config for OpenGL" << std::endl;
+            return false;
+        }
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create an OpenGL 4.3 context: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+    eglContext = context;
+
+    // the pbuffer stands in for the window's default framebuffer
+    EGLSurface surface = EGL_NO_SURFACE;
+    if (pbuffer) {
+        const EGLint surfaceAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    }
+    eglSurface = surface;
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        std::cerr << "Failed to make the EGL context current: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    std::clog << "headless EGL " << major << "." << minor << (surface == EGL_NO_SURFACE ? " surfaceless" : " pbuffer")
+          << ": " << glGetString(GL_RENDERER) << std::endl;
+    return true;
+#else
+    (void)width;
+    (void)height;
+    std::cerr << "Headless mode needs EGL, this build has none" << std::endl;
+    return false;
+#endif
+}
+
+bool AppContext::nextFrame() {
+    if (frame == 0)
+        start = std::chrono::steady_clock::now();
+    if (options.headless && frame >= options.frames)
+        return false;
+    frame++;
+    return true;
+}
+
+void AppContext::setResizable(bool resizable) {
+    if (window)
+        SDL_SetWindowResizable(window, resizable);
+}
+
+void AppContext::getDrawableSize(int& width, int& height) const {
+    if (window && SDL_GetWindowSizeInPixels(window, &width, &height))
+        return;
+    width = this->width;
+    height = this->height;
+}
+
+void AppContext::makeCurrent() {
+    if (window && glContext)
+        SDL_GL_MakeCurrent(window, glContext);
+#ifdef CS_HEADLESS_EGL
+    else if (eglContext)
+        eglMakeCurrent((EGLDisplay)eglDisplay, (EGLSurface)eglSurface, (EGLSurface)eglSurface, (EGLContext)eglContext);
+#endif
+}
+
+void AppContext::swap() {
+    if (window && glContext)
+        SDL_GL_SwapWindow(window);
+    else if (eglContext)
+        glFlush();
+}
+
+void AppContext::destroy() {
+    if (options.headless && frame > 0) {
+        if (eglContext)
+            glFinish();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "headless: " << frame << " frames, " << ms / frame << " ms/frame, "
+                  << frame * 1000.0 / ms << " FPS" << std::endl;
+        frame = 0;
+    }
+
+#ifdef CS_HEADLESS_EGL
+    if (eglDisplay) {
+        eglMakeCurrent((EGLDisplay)eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (eglSurface)
+            eglDestroySurface((EGLDisplay)eglDisplay, (EGLSurface)eglSurface);
+        if (eglContext)
+            eglDestroyContext((EGLDisplay)eglDisplay, (EGLContext)eglContext);
+        eglTerminate((EGLDisplay)eglDisplay);
+    }
+#endif
+    eglDisplay = eglContext = eglSurface = nullptr;
+
+    if (glContext)
+        SDL_GL_DestroyContext(glContext);
+    glContext = nullptr;
+    if (window)
+        SDL_DestroyWindow(window);
+    window = nullptr;
+    SDL_Quit();
+}
+
+bool writeRGBA8PPM(const std::string& path, const unsigned char* rgba, int width, int height, bool bottomUp) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+    std::vector<unsigned char> row((size_t)width * 3);
+    for (int i = 0; i < height; i++) {
+        const unsigned char* src = rgba + (size_t)(bottomUp ? height - 1 - i : i) * width * 4;
+        for (int x = 0; x < width; x++) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+    return std::fclose(file) == 0;
+}
+
+bool saveTexturePPM(const std::string& path, GLuint texture, int width, int height) {
+    // through a read framebuffer, so only the width x height corner is read
+    // when the texture is larger (pooled render targets)
+    GLint previousRead = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+    std::vector<unsigned char> pixels((size_t)width * height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+    glDeleteFramebuffers(1, &fbo);
+    return writeRGBA8PPM(path, pixels.data(), width, height, true);
+}
@@ -0,0 +1,283 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <mutex>
+#include <utility>
+
+namespace {
+    struct Bounds
+    {
+        glm::vec3 lo = glm::vec3(FLT_MAX);
+        glm::vec3 hi = glm::vec3(-FLT_MAX);
+
+        void grow(const glm::vec3& p) { lo = glm::min(lo, p); hi = glm::max(hi, p); }
+        void grow(const Bounds& b) { lo = glm::min(lo, b.lo); hi = glm::max(hi, b.hi); }
+        float area() const
+        {
+            glm::vec3 e = hi - lo;
+            if (e.x < 0.0f) return 0.0f;
+            return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+        }
+    };
+}
+
+struct SphereBVH::Builder
+{
+    ThreadPool& pool;
+    std::vector<glm::vec3> centroid;
+    std::vector<Bounds> primBounds;
+    std::vector<int> indices;
+    std::vector<BVHNode>& nodes;
+    std::atomic<int> used{1};
+    std::mutex depthMutex;
+    int maxDepth = 0;
+
+    Builder(ThreadPool& pool, std::vector<BVHNode>& nodes) : pool(pool), nodes(nodes) {}
+
+    void makeLeaf(BVHNode& node, int first, int count, int depth)
+    {
+        node.leftFirst = first;
+        node.count = count;
+        std::lock_guard<std::mutex> lock(depthMutex);
+        maxDepth = std::max(maxDepth, depth);
+    }
+
+    void buildNode(int nodeIndex, int first, int count, int depth)
+    {
+        BVHNode& node = nodes[nodeIndex];
+        Bounds bounds, centroidBounds;
+        for (int i = first; i < first + count; i++) {
+            bounds.grow(primBounds[indices[i]]);
+            centroidBounds.grow(centroid[indices[i]]);
+        }
+        node.boundsMin = bounds.lo;
+        node.boundsMax = bounds.hi;
+
+        if (count <= MAX_LEAF_SIZE || depth >= MAX_DEPTH) {
+            makeLeaf(node, first, count, depth);
+            return;
+        }
+
+        // binned SAH: SAH_BINS buckets along each axis of the centroid bounds
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = FLT_MAX;
+        glm::vec3 extent = centroidBounds.hi - centroidBounds.lo;
+
+        for (int axis = 0; axis < 3; axis++) {
+            if (extent[axis] <= 0.0f) continue;
+            Bounds binBounds[SAH_BINS];
+            int binCount[SAH_BINS] = {};
+            float scale = SAH_BINS / extent[axis];
+            for (int i = first; i < first + count; i++) {
+                int b = std::min(SAH_BINS - 1, (int)((centroid[indices[i]][axis] - centroidBounds.lo[axis]) * scale));
+                binCount[b]++;
+                binBounds[b].grow(primBounds[indices[i]]);
+            }
+
+            // sweep from both ends to get the cost of every split plane
+            float leftArea[SAH_BINS - 1], rightArea[SAH_BINS - 1];
+            int leftCount[SAH_BINS - 1], rightCount[SAH_BINS - 1];
+            Bounds left, right;
+            int leftSum = 0, rightSum = 0;
+            for (int b = 0; b < SAH_BINS - 1; b++) {
+                leftSum += binCount[b];
+                left.grow(binBounds[b]);
+                leftCount[b] = leftSum;
+                leftArea[b] = left.area();
+
+                rightSum += binCount[SAH_BINS - 1 - b];
+                right.grow(binBounds[SAH_BINS - 1 - b]);
+                rightCount[SAH_BINS - 2 - b] = rightSum;
+                rightArea[SAH_BINS - 2 - b] = right.area();
+            }
+            for (int b = 0; b < SAH_BINS - 1; b++) {
+                float cost = leftCount[b] * leftArea[b] + rightCount[b] * rightArea[b];
+                if (leftCount[b] > 0 && rightCount[b] > 0 && cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+
+        // all centroids on top of each other, or splitting costs more than testing them all
+        float leafCost = count * bounds.area();
+        if (bestAxis < 0 || (bestCost >= leafCost && count <= 4 * MAX_LEAF_SIZE)) {
+            makeLeaf(node, first, count, depth);
+            return;
+        }
+
+        float scale = SAH_BINS / extent[bestAxis];
+        float lo = centroidBounds.lo[bestAxis];
+        int* mid = std::partition(indices.data() + first, indices.data() + first + count, [&](int prim) {
+            return std::min(SAH_BINS - 1, (int)((centroid[prim][bestAxis] - lo) * scale)) <= bestSplit;
+        });
+        int leftCount = (int)(mid - (indices.data() + first));
+
+        int children = used.fetch_add(2);
+        node.leftFirst = children;
+        node.count = 0;
+
+        if (count > PARALLEL_THRESHOLD) {
+            pool.parallelFor(2, [&](int c) {
+                if (c == 0) buildNode(children, first, leftCount, depth + 1);
+                else buildNode(children + 1, first + leftCount, count - leftCount, depth + 1);
+            });
+        }
+        else {
+            buildNode(children, first, leftCount, depth + 1);
+            buildNode(children + 1, first + leftCount, count - leftCount, depth + 1);
+        }
+    }
+};
+
+void SphereBVH::build(SphereScene& scene, ThreadPool& pool) {
+    int count = scene.size();
+    nodes.assign(std::max(2 * count - 1, 1), BVHNode());
+
+    Builder builder(pool, nodes);
+    builder.centroid.resize(count);
+    builder.primBounds.resize(count);
+    builder.indices.resize(count);
+    SphereSceneView view = scene.view();
+    for (int i = 0; i < count; i++) {
+        glm::vec3 c = view.center(i);
+        builder.centroid[i] = c;
+        builder.primBounds[i].lo = c - glm::vec3(view.radius[i]);
+        builder.primBounds[i].hi = c + glm::vec3(view.radius[i]);
+        builder.indices[i] = i;
+    }
+
+    builder.buildNode(0, 0, count, 0);
+    nodes.resize(builder.used.load());
+    maxDepth = builder.maxDepth;
+
+    // reorder the spheres so that leaves index them directly
+    std::vector<glm::vec4> sorted(count);
+    for (int i = 0; i < count; i++)
+        sorted[i] = scene.get(builder.indices[i]);
+    for (int i = 0; i < count; i++)
+        scene.set(i, sorted[i]);
+}
+
+void SphereBVH::tracePacket(RayPacket& packet, const glm::vec3& ro, const SphereSceneView& spheres) const {
+    if (spheres.count == 0 || nodes.empty())
+        return;
+
+    float invX[RayPacket::MAX_RAYS], invY[RayPacket::MAX_RAYS], invZ[RayPacket::MAX_RAYS];
+    for (int k = 0; k < packet.count; k++) {
+        invX[k] = 1.0f / packet.dirX[k];
+        invY[k] = 1.0f / packet.dirY[k];
+        invZ[k] = 1.0f / packet.dirZ[k];
+    }
+
+    // entry distance of the first packet ray that can still hit the box, FLT_MAX if none
+    auto hitBox = [&](const BVHNode& node) {
+        for (int k = 0; k < packet.count; k++) {
+            float tx0 = (node.boundsMin.x - ro.x) * invX[k], tx1 = (node.boundsMax.x - ro.x) * invX[k];
+            float ty0 = (node.boundsMin.y - ro.y) * invY[k], ty1 = (node.boundsMax.y - ro.y) * invY[k];
+            float tz0 = (node.boundsMin.z - ro.z) * invZ[k], tz1 = (node.boundsMax.z - ro.z) * invZ[k];
+            float tnear = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::min(tz0, tz1));
+            float tfar = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::max(tz0, tz1));
+            if (tfar >= std::max(tnear, 0.0f) && tnear < packet.tmin[k])
+                return std::max(tnear, 0.0f);
+        }
+        return FLT_MAX;
+    };
+
+    int stack[64];
+    int sp = 0;
+    if (hitBox(nodes[0]) == FLT_MAX)
+        return;
+    stack[sp++] = 0;
+
+    while (sp > 0) {
+        const BVHNode& node = nodes[stack[--sp]];
+        if (node.isLeaf()) {
+            // a closer hit found since the push may have hidden it already
+            if (hitBox(node) == FLT_MAX)
+                continue;
+            ::tracePacket(packet, ro, spheres, node.leftFirst, node.leftFirst + node.count);
+            continue;
+        }
+
+        // push the far child first so the near one is visited next
+        float tl = hitBox(nodes[node.leftFirst]);
+        float tr = hitBox(nodes[node.leftFirst + 1]);
+        int nearChild = tl <= tr ? node.leftFirst : node.leftFirst + 1;
+        int farChild = tl <= tr ? node.leftFirst + 1 : node.leftFirst;
+        if (std::max(tl, tr) != FLT_MAX) stack[sp++] = farChild;
+        if (std::min(tl, tr) != FLT_MAX) stack[sp++] = nearChild;
+    }
+}
+
+float SphereBVH::shadow(const glm::vec3& ro, const glm::vec3& rd, const SphereSceneView& spheres) const {
+    float sha = 1.0f;
+    if (spheres.count == 0 || nodes.empty())
+        return sha;
+
+    glm::vec3 ird = 1.0f / rd;
+    int stack[64];
+    int sp = 0;
+    stack[sp++] = 0;
+
+    while (sp > 0) {
+        const BVHNode& node = nodes[stack[--sp]];
+        float margin = shadowMargin(node, ro, rd);
+        if (margin < 0.0f)
+            continue;
+        glm::vec3 t0 = (node.boundsMin - margin - ro) * ird;
+        glm::vec3 t1 = (node.boundsMax + margin - ro) * ird;
+        glm::vec3 tn = glm::min(t0, t1), tf = glm::max(t0, t1);
+        float tnear = std::max(std::max(tn.x, tn.y), tn.z);
+        float tfar = std::min(std::min(tf.x, tf.y), tf.z);
+        if (tfar < std::max(tnear, 0.0f))
+            continue;
+
+        if (node.isLeaf()) {
+            for (int i = node.leftFirst; i < node.leftFirst + node.count; i++)
+                sha *= softShadow(ro, rd, spheres.sphere(i));
+        }
+        else {
+            stack[sp++] = node.leftFirst;
+            stack[sp++] = node.leftFirst + 1;
+        }
+    }
+    return sha;
+}
+
+SphereBVH::SphereBVH(SphereBVH&& other) noexcept {
+    *this = std::move(other);
+}
+
+SphereBVH& SphereBVH::operator=(SphereBVH&& other) noexcept {
+    if (this == &other)
+        return *this;
+    release();
+    nodes = std::move(other.nodes);
+    maxDepth = std::exchange(other.maxDepth, 0);
+    nodesBuffer = std::exchange(other.nodesBuffer, 0);
+    return *this;
+}
+
+void SphereBVH::upload() {
+    if (nodesBuffer == 0)
+        glGenBuffers(1, &nodesBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, nodesBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, nodes.size() * sizeof(BVHNode), nodes.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    bind();
+}
+
+void SphereBVH::bind() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, NODES_BINDING, nodesBuffer);
+}
+
+void SphereBVH::release() {
+    if (nodesBuffer != 0)
+        glDeleteBuffers(1, &nodesBuffer);
+    nodesBuffer = 0;
+}
@@ -0,0 +1,326 @@
+#include "compute_primitives.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <limits>
+#include <string>
+#include <vector>
+
+// GL guarantees at least this many workgroups per dimension
+static const size_t MAX_GROUPS_X = 65535;
+
+glm::uvec3 linearGroups(size_t groupCount) {
+    size_t y = std::max<size_t>(1, (groupCount + MAX_GROUPS_X - 1) / MAX_GROUPS_X);
+    size_t x = std::max<size_t>(1, (groupCount + y - 1) / y);
+    return glm::uvec3((unsigned)x, (unsigned)y, 1u);
+}
+
+static void dispatchLinear(const ComputeShader& shader, size_t groupCount) {
+    glm::uvec3 groups = linearGroups(groupCount);
+    shader.dispatch(groups.x, groups.y, groups.z);
+}
+
+// (re)allocates a set of buffers sharing one capacity for at least bytes
+// each, keeping them when they are big enough
+static void reserveBuffers(std::initializer_list<GLuint*> buffers, size_t& capacity, size_t bytes) {
+    if (capacity >= bytes)
+        return;
+    for (GLuint* buffer : buffers) {
+        if (!*buffer)
+            glGenBuffers(1, buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, *buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
+    }
+    capacity = bytes;
+}
+
+static bool buildShader(std::unique_ptr<ComputeShader>& shader, const char* path, const std::string& defines) {
+    shader.reset(new ComputeShader(ProgramBuilder::compute(path, defines)));
+    return shader->ID != 0;
+}
+
+static void deleteShader(std::unique_ptr<ComputeShader>& shader) {
+    if (shader)
+        glDeleteProgram(shader->ID);
+    shader.reset();
+}
+
+// ----------------------------------------------------------------------------
+
+bool GpuReduce::create(ReduceOp op) {
+    release();
+    reduceOp = op;
+    glGenBuffers(1, &resultBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, resultBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float), nullptr, GL_DYNAMIC_READ);
+    return buildShader(shader, "reduce.cs", "#define REDUCE_OP " + std::to_string((int)op) + "\n");
+}
+
+void GpuReduce::dispatch(GLuint input, size_t count) {
+    size_t groups = std::max<size_t>(1, (count + ELEMENTS_PER_GROUP - 1) / ELEMENTS_PER_GROUP);
+    // the first pass writes the most partials, later ones fit in the same buffers
+    if (groups > 1)
+        reserveBuffers({ &partials[0], &partials[1] }, partialCapacity, groups * sizeof(float));
+
+    shader->use();
+    GLuint in = input;
+    int pass = 0;
+    while (true) {
+        groups = std::max<size_t>(1, (count + ELEMENTS_PER_GROUP - 1) / ELEMENTS_PER_GROUP);
+        GLuint out = groups == 1 ? resultBuffer : partials[pass % 2];
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, in);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, out);
+        shader->setInt("count", (int)count);
+        dispatchLinear(*shader, groups);
+        if (groups == 1)
+            break;
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        in = out;
+        count = groups;
+        pass++;
+    }
+}
+
+float GpuReduce::read() const {
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    float value = 0.0f;
+    glBindBuffer(GL_COPY_READ_BUFFER, resultBuffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(float), &value);
+    return value;
+}
+
+void GpuReduce::release() {
+    deleteShader(shader);
+    if (partials[0])
+        glDeleteBuffers(2, partials);
+    partials[0] = partials[1] = 0;
+    partialCapacity = 0;
+    if (resultBuffer)
+        glDeleteBuffers(1, &resultBuffer);
+    resultBuffer = 0;
+}
+
+// ----------------------------------------------------------------------------
+
+bool GpuScan::create() {
+    release();
+    return buildShader(shader, "scan.cs", "");
+}
+
+void GpuScan::dispatch(GLuint input, GLuint output, size_t count) {
+    size_t partitions = std::max<size_t>(1, (count + PARTITION_SIZE - 1) / PARTITION_SIZE);
+    // ScanState: nextPartition padded to 16 bytes, then 4 uints per partition
+    reserveBuffers({ &stateBuffer }, stateCapacity, 16 + partitions * 16);
+    // the previous scan's look-back writes must land before the clear
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, stateBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+    shader->use();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, input);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, output);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, stateBuffer);
+    shader->setInt("count", (int)count);
+    // linearGroups may round the grid up; groups past partitions do nothing
+    shader->setInt("partitionCount", (int)partitions);
+    dispatchLinear(*shader, partitions);
+}
+
+void GpuScan::release() {
+    deleteShader(shader);
+    if (stateBuffer)
+        glDeleteBuffers(1, &stateBuffer);
+    stateBuffer = 0;
+    stateCapacity = 0;
+}
+
+// ----------------------------------------------------------------------------
+
+bool GpuHistogram::create(int binCount) {
+    release();
+    bins = binCount;
+    return buildShader(shader, "histogram.cs", "#define NUM_BINS " + std::to_string(binCount) + "\n");
+}
+
+void GpuHistogram::dispatch(GLuint keys, size_t count, GLuint binBuffer, int shift, bool clear) {
+    if (clear) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, binBuffer);
+        glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, bins * sizeof(uint32_t),
+                             GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    }
+    shader->use();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, keys);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, binBuffer);
+    shader->setInt("count", (int)count);
+    shader->setInt("shift", shift);
+    dispatchLinear(*shader, (count + ELEMENTS_PER_GROUP - 1) / ELEMENTS_PER_GROUP);
+}
+
+void GpuHistogram::release() {
+    deleteShader(shader);
+    bins = 0;
+}
+
+// ----------------------------------------------------------------------------
+
+bool GpuRadixSort::create() {
+    release();
+    std::string radix = std::to_string(1 << RADIX_BITS);
+    return buildShader(histogramShader, "histogram.cs", "#define NUM_BINS " + radix + "\n#define PER_GROUP_BINS\n")
+        && buildShader(scatterShader, "radix_scatter.cs", "#define RADIX_BITS " + std::to_string(RADIX_BITS) + "\n")
+        && scan.create();
+}
+
+void GpuRadixSort::sort(GLuint keys, GLuint values, size_t count, int keyBits) {
+    if (count < 2)
+        return;
+    size_t groups = (count + PARTITION_SIZE - 1) / PARTITION_SIZE;
+    size_t digitCounts = ((size_t)1 << RADIX_BITS) * groups;
+    reserveBuffers({ &keysAlt, &valuesAlt }, altCapacity, count * sizeof(uint32_t));
+    reserveBuffers({ &countsBuffer, &offsetsBuffer }, countsCapacity, digitCounts * sizeof(uint32_t));
+
+    GLuint keysIn = keys, valuesIn = values, keysOut = keysAlt, valuesOut = valuesAlt;
+    int passes = (keyBits + RADIX_BITS - 1) / RADIX_BITS;
+    for (int pass = 0; pass < passes; pass++) {
+        int shift = pass * RADIX_BITS;
+
+        histogramShader->use();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, keysIn);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, countsBuffer);
+        histogramShader->setInt("count", (int)count);
+        histogramShader->setInt("shift", shift);
+        dispatchLinear(*histogramShader, groups);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        scan.dispatch(countsBuffer, offsetsBuffer, digitCounts);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        scatterShader->use();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, keysIn);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, valuesIn);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, keysOut);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, valuesOut);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, offsetsBuffer);
+        scatterShader->setInt("count", (int)count);
+        scatterShader->setInt("shift", shift);
+        dispatchLinear(*scatterShader, groups);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        std::swap(keysIn, keysOut);
+        std::swap(valuesIn, valuesOut);
+    }
+
+    // an odd number of passes leaves the result in the scratch buffers
+    if (keysIn != keys) {
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_COPY_READ_BUFFER, keysIn);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, keys);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, count * sizeof(uint32_t));
+        glBindBuffer(GL_COPY_READ_BUFFER, valuesIn);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, values);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, count * sizeof(uint32_t));
+    }
+}
+
+void GpuRadixSort::release() {
+    deleteShader(histogramShader);
+    deleteShader(scatterShader);
+    scan.release();
+    GLuint buffers[] = { keysAlt, valuesAlt, countsBuffer, offsetsBuffer };
+    for (GLuint buffer : buffers)
+        if (buffer)
+            glDeleteBuffers(1, &buffer);
+    keysAlt = valuesAlt = countsBuffer = offsetsBuffer = 0;
+    altCapacity = countsCapacity = 0;
+}
+
+// ----------------------------------------------------------------------------
+
+float cpuReduce(const float* values, size_t count, ReduceOp op) {
+    if (op == ReduceOp::Sum) {
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++)
+            sum += values[i];
+        return (float)sum;
+    }
+    float result = op == ReduceOp::Min ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < count; i++)
+        result = op == ReduceOp::Min ? std::min(result, values[i]) : std::max(result, values[i]);
+    return result;
+}
+
+void cpuExclusiveScan(const uint32_t* input, uint32_t* output, size_t count) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t value = input[i];
+        output[i] = sum;
+        sum += value;
+    }
+}
+
+void cpuHistogram(const uint32_t* keys, size_t count, uint32_t* bins, int binCount, int shift) {
+    std::fill(bins, bins + binCount, 0u);
+    uint32_t mask = (uint32_t)binCount - 1;
+    for (size_t i = 0; i < count; i++)
+        bins[(keys[i] >> shift) & mask]++;
+}
+
+void cpuRadixSort(uint32_t* keys, uint32_t* values, size_t count, int keyBits, ThreadPool& pool) {
+    const int BITS = 8;
+    const int RADIX = 1 << BITS;
+    // below this a chunk costs more to hand out than to sort
+    const size_t MIN_CHUNK = 1 << 16;
+    if (count < 2)
+        return;
+
+    size_t chunks = std::max<size_t>(1, std::min<size_t>(pool.size() * 4, count / MIN_CHUNK));
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    std::vector<uint32_t> keysAlt(count), valuesAlt(count);
+    // offsets[chunk * RADIX + digit]: counts, then where the chunk's keys of that digit go
+    std::vector<size_t> offsets(chunks * RADIX);
+
+    uint32_t* keysIn = keys;
+    uint32_t* valuesIn = values;
+    uint32_t* keysOut = keysAlt.data();
+    uint32_t* valuesOut = valuesAlt.data();
+    int passes = (keyBits + BITS - 1) / BITS;
+    for (int pass = 0; pass < passes; pass++) {
+        int shift = pass * BITS;
+
+        pool.parallelFor((int)chunks, [&](int chunk) {
+            size_t* counts = &offsets[chunk * RADIX];
+            std::fill(counts, counts + RADIX, 0);
+            size_t end = std::min(count, (chunk + 1) * chunkSize);
+            for (size_t i = chunk * chunkSize; i < end; i++)
+                counts[(keysIn[i] >> shift) & (RADIX - 1)]++;
+        });
+
+        // digit-major exclusive scan: all keys of a digit, chunk by chunk
+        size_t position = 0;
+        for (int digit = 0; digit < RADIX; digit++)
+            for (size_t chunk = 0; chunk < chunks; chunk++) {
+                size_t n = offsets[chunk * RADIX + digit];
+                offsets[chunk * RADIX + digit] = position;
+                position += n;
+            }
+
+        // every chunk writes its own ranges, in order, so the sort is stable
+        pool.parallelFor((int)chunks, [&](int chunk) {
+            size_t* next = &offsets[chunk * RADIX];
+            size_t end = std::min(count, (chunk + 1) * chunkSize);
+            for (size_t i = chunk * chunkSize; i < end; i++) {
+                size_t destination = next[(keysIn[i] >> shift) & (RADIX - 1)]++;
+                keysOut[destination] = keysIn[i];
+                valuesOut[destination] = valuesIn[i];
+            }
+        });
+
+        std::swap(keysIn, keysOut);
+        std::swap(valuesIn, valuesOut);
+    }
+
+    if (keysIn != keys) {
+        std::copy(keysIn, keysIn + count, keys);
+        std::copy(valuesIn, valuesIn + count, values);
+    }
+}
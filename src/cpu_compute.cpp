@@ -0,0 +1,256 @@
+#include "cpu_compute.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+
+// float rounded to a mantissa of the given width, as the small float
+// formats store it (no denormal or range handling, the kernels stay in range)
+static float roundMantissa(float value, int bits) {
+    if (value == 0.0f || !std::isfinite(value))
+        return value;
+    int exponent;
+    float mantissa = std::frexp(value, &exponent);
+    float scale = (float)(1 << (bits + 1));
+    return std::ldexp(std::round(mantissa * scale) / scale, exponent);
+}
+
+CpuImage::CpuImage(int width, int height, GLenum internalFormat)
+    : w(width), h(height), internalFormat(internalFormat), texels((size_t)width * height, glm::vec4(0.0f)) {
+}
+
+void CpuImage::store(const glm::ivec2& coords, const glm::vec4& value) {
+    if (coords.x < 0 || coords.y < 0 || coords.x >= w || coords.y >= h)
+        return;
+    glm::vec4 v = value;
+    if (internalFormat == GL_RGBA8) {
+        v = glm::floor(glm::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f) / 255.0f;
+    }
+    else if (internalFormat == GL_RGBA16F) {
+        for (int i = 0; i < 4; i++)
+            v[i] = roundMantissa(v[i], 10);
+    }
+    else if (internalFormat == GL_R11F_G11F_B10F) {
+        // unsigned, no alpha channel: alpha reads back as 1
+        v = glm::vec4(roundMantissa(std::max(v.r, 0.0f), 6), roundMantissa(std::max(v.g, 0.0f), 6),
+                      roundMantissa(std::max(v.b, 0.0f), 5), 1.0f);
+    }
+    texels[(size_t)coords.y * w + coords.x] = v;
+}
+
+glm::vec4 CpuImage::load(const glm::ivec2& coords) const {
+    if (coords.x < 0 || coords.y < 0 || coords.x >= w || coords.y >= h)
+        return glm::vec4(0.0f);
+    return texels[(size_t)coords.y * w + coords.x];
+}
+
+void CpuImage::readRGBA8(std::vector<unsigned char>& out) const {
+    out.resize(texels.size() * 4);
+    for (size_t i = 0; i < texels.size(); i++) {
+        glm::vec4 v = glm::clamp(texels[i], 0.0f, 1.0f) * 255.0f + 0.5f;
+        out[i * 4 + 0] = (unsigned char)v.x;
+        out[i * 4 + 1] = (unsigned char)v.y;
+        out[i * 4 + 2] = (unsigned char)v.z;
+        out[i * 4 + 3] = (unsigned char)v.w;
+    }
+}
+
+bool CpuImage::writePPM(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    std::fprintf(file, "P6\n%d %d\n255\n", w, h);
+    std::vector<unsigned char> row((size_t)w * 3);
+    for (int y = h - 1; y >= 0; y--) {
+        for (int x = 0; x < w; x++) {
+            glm::vec4 v = glm::clamp(texels[(size_t)y * w + x], 0.0f, 1.0f) * 255.0f + 0.5f;
+            row[x * 3 + 0] = (unsigned char)v.x;
+            row[x * 3 + 1] = (unsigned char)v.y;
+            row[x * 3 + 2] = (unsigned char)v.z;
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+    return std::fclose(file) == 0;
+}
+
+int CpuUniforms::slot(const std::string& name) {
+    auto it = slots.find(name);
+    if (it != slots.end())
+        return it->second;
+    values.push_back(Value());
+    slots.emplace(name, (int)values.size() - 1);
+    return (int)values.size() - 1;
+}
+
+void CpuUniforms::setFloats(int slot, const float* v, int count) {
+    if (slot < 0 || slot >= (int)values.size())
+        return;
+    Value& value = values[slot];
+    for (int k = 0; k < count && k < 16; k++) {
+        value.f[k] = v[k];
+        value.i[k] = (int)v[k];
+    }
+}
+
+void CpuUniforms::setInts(int slot, const int* v, int count) {
+    if (slot < 0 || slot >= (int)values.size())
+        return;
+    Value& value = values[slot];
+    for (int k = 0; k < count && k < 16; k++) {
+        value.i[k] = v[k];
+        value.f[k] = (float)v[k];
+    }
+}
+
+const CpuUniforms::Value* CpuUniforms::find(const std::string& name) const {
+    auto it = slots.find(name);
+    return it == slots.end() ? nullptr : &values[it->second];
+}
+
+float CpuUniforms::getFloat(const std::string& name) const {
+    const Value* v = find(name);
+    return v ? v->f[0] : 0.0f;
+}
+
+int CpuUniforms::getInt(const std::string& name) const {
+    const Value* v = find(name);
+    return v ? v->i[0] : 0;
+}
+
+glm::vec2 CpuUniforms::getVec2(const std::string& name) const {
+    const Value* v = find(name);
+    return v ? glm::vec2(v->f[0], v->f[1]) : glm::vec2(0.0f);
+}
+
+glm::vec3 CpuUniforms::getVec3(const std::string& name) const {
+    const Value* v = find(name);
+    return v ? glm::vec3(v->f[0], v->f[1], v->f[2]) : glm::vec3(0.0f);
+}
+
+glm::vec4 CpuUniforms::getVec4(const std::string& name) const {
+    const Value* v = find(name);
+    return v ? glm::vec4(v->f[0], v->f[1], v->f[2], v->f[3]) : glm::vec4(0.0f);
+}
+
+glm::ivec2 CpuUniforms::getIVec2(const std::string& name) const {
+    const Value* v = find(name);
+    return v ? glm::ivec2(v->i[0], v->i[1]) : glm::ivec2(0);
+}
+
+glm::mat4 CpuUniforms::getMat4(const std::string& name) const {
+    glm::mat4 m(0.0f);
+    const Value* v = find(name);
+    if (v)
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 4; r++)
+                m[c][r] = v->f[c * 4 + r];
+    return m;
+}
+
+namespace {
+    std::mutex registryMutex;
+
+    std::unordered_map<std::string, CpuKernelFactory>& registry() {
+        static std::unordered_map<std::string, CpuKernelFactory> kernels;
+        return kernels;
+    }
+
+    // bytes rounded up so that every block of the scratch memory stays aligned
+    std::size_t alignedSize(std::size_t bytes) {
+        std::size_t align = sizeof(std::max_align_t);
+        return (bytes + align - 1) / align * align;
+    }
+
+    std::string fileName(const std::string& path) {
+        size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+}
+
+void registerCpuKernel(const std::string& shaderName, CpuKernelFactory factory) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry()[fileName(shaderName)] = factory;
+}
+
+std::unique_ptr<CpuKernel> createCpuKernel(const std::string& shaderPath) {
+    // done here rather than from static initializers, which the linker may
+    // drop from a static library
+    static std::once_flag builtins;
+    std::call_once(builtins, registerBuiltinCpuKernels);
+
+    CpuKernelFactory factory = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto it = registry().find(fileName(shaderPath));
+        if (it != registry().end())
+            factory = it->second;
+    }
+    return factory ? factory() : nullptr;
+}
+
+void cpuDispatch(CpuKernel& kernel, const glm::uvec3& numGroups, ThreadPool& pool) {
+    cpuDispatch(kernel, numGroups, kernel.localSize(), pool);
+}
+
+void cpuDispatch(CpuKernel& kernel, const glm::uvec3& numGroups, const glm::uvec3& localSize, ThreadPool& pool) {
+    // glDispatchCompute raises GL_INVALID_VALUE and runs nothing past the limit
+    if (numGroups.x > CPU_MAX_WORK_GROUP_COUNT || numGroups.y > CPU_MAX_WORK_GROUP_COUNT
+        || numGroups.z > CPU_MAX_WORK_GROUP_COUNT) {
+        std::fprintf(stderr, "cpuDispatch: %u x %u x %u workgroups, the limit is %u per dimension\n",
+                     numGroups.x, numGroups.y, numGroups.z, CPU_MAX_WORK_GROUP_COUNT);
+        return;
+    }
+    uint64_t groupCount = (uint64_t)numGroups.x * numGroups.y * numGroups.z;
+    if (groupCount == 0)
+        return;
+
+    // a task per workgroup costs more than small workgroups take to run,
+    // so hand out runs of consecutive groups (about 16 per thread)
+    uint64_t groupsPerTask = std::max<uint64_t>(1, groupCount / (pool.size() * 16));
+    int taskCount = (int)((groupCount + groupsPerTask - 1) / groupsPerTask);
+    glm::uvec3 local = localSize;
+
+    // shared variables of the running workgroup followed by the locals of
+    // each of its invocations, allocated once per task and reused by its groups
+    unsigned int invocationCount = local.x * local.y * local.z;
+    std::size_t sharedBytes = alignedSize(kernel.sharedSize(local));
+    std::size_t localsBytes = alignedSize(kernel.localsSize());
+    std::size_t scratchBytes = sharedBytes + localsBytes * invocationCount;
+    int phaseCount = kernel.barrierCount() + 1;
+
+    pool.parallelFor(taskCount, [&](int task) {
+        uint64_t begin = task * groupsPerTask;
+        uint64_t end = std::min(groupCount, begin + groupsPerTask);
+
+        std::vector<std::max_align_t> scratch(scratchBytes / sizeof(std::max_align_t));
+        unsigned char* memory = (unsigned char*)scratch.data();
+
+        CpuInvocation inv;
+        inv.numWorkGroups = numGroups;
+        inv.workGroupSize = local;
+        inv.shared = sharedBytes ? memory : nullptr;
+        uint64_t groupsPerSlice = (uint64_t)numGroups.x * numGroups.y;
+        for (uint64_t g = begin; g < end; g++) {
+            inv.workGroupID = glm::uvec3(g % numGroups.x, (g / numGroups.x) % numGroups.y, g / groupsPerSlice);
+            for (int phase = 0; phase < phaseCount; phase++) {
+                unsigned int index = 0;
+                for (unsigned int z = 0; z < local.z; z++)
+                    for (unsigned int y = 0; y < local.y; y++)
+                        for (unsigned int x = 0; x < local.x; x++) {
+                            inv.localInvocationID = glm::uvec3(x, y, z);
+                            inv.globalInvocationID = inv.workGroupID * local + inv.localInvocationID;
+                            inv.localInvocationIndex = index;
+                            inv.locals = localsBytes ? memory + sharedBytes + localsBytes * index : nullptr;
+                            index++;
+                            if (phaseCount == 1)
+                                kernel.invoke(inv);
+                            else
+                                kernel.invokePhase(inv, phase);
+                        }
+            }
+        }
+    });
+}
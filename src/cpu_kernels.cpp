@@ -0,0 +1,578 @@
+#include "cpu_compute.h"
+#include "bvh.h"
+#include "frame_params.h"
+#include "pixel_order.h"
+
+#include <algorithm>
+#include <cmath>
+
+// C++ ports of the .cs kernels. Each one follows its shader line by line so
+// that a change in the GLSL is easy to mirror here; keep them in sync.
+
+namespace {
+    // GLSL mod(), which unlike fmod rounds towards -inf
+    float mod(float x, float y) { return x - y * std::floor(x / y); }
+
+    float smoothstep(float e0, float e1, float x)
+    {
+        float t = std::min(std::max((x - e0) / (e1 - e0), 0.0f), 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    float fract(float x) { return x - std::floor(x); }
+
+    // the early-out of every kernel: any(greaterThanEqual(coords, dispatchExtent.xy))
+    bool outside(const glm::ivec2& coords, const glm::ivec2& extent)
+    {
+        return coords.x >= extent.x || coords.y >= extent.y;
+    }
+
+    // pixelGroup() and pixelCoords() of computeShader2.cs / computeSh_test6.cs
+    glm::uvec2 pixelGroup(const CpuInvocation& inv, int pixelOrder)
+    {
+        if (pixelOrder == 0)
+            return glm::uvec2(inv.workGroupID);
+        return mortonCell(inv.workGroupID.x + inv.workGroupID.y * inv.numWorkGroups.x, glm::uvec2(inv.numWorkGroups));
+    }
+
+    glm::ivec2 pixelCoords(const CpuInvocation& inv, const glm::uvec2& group, int pixelOrder)
+    {
+        if (pixelOrder == 0)
+            return glm::ivec2(inv.globalInvocationID);
+        glm::uvec2 size(inv.workGroupSize);
+        return glm::ivec2(group * size + mortonLocal(inv.localInvocationIndex, size));
+    }
+
+    // ------------------------------------------------------------------------
+    // computeShader.cs
+    // ------------------------------------------------------------------------
+    class GradientKernel : public CpuKernel
+    {
+    public:
+        glm::uvec3 localSize() const override { return glm::uvec3(10, 10, 1); }
+
+        void prepare(const CpuUniforms& uniforms, const CpuBindings& bindings) override
+        {
+            t = uniforms.getFloat("t");
+            extent = uniforms.getIVec2("dispatchExtent");
+            imgOutput = bindings.images[0];
+        }
+
+        void invoke(const CpuInvocation& inv) const override
+        {
+            glm::vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+            glm::ivec2 texelCoord((int)inv.globalInvocationID.x, (int)inv.globalInvocationID.y);
+            if (outside(texelCoord, extent))
+                return;
+            float speed = 100;
+            float width = float(extent.x);
+
+            value.x = mod(float(texelCoord.x) + t * speed, width) / width;
+            value.y = float(texelCoord.y) / float(extent.y);
+            if (imgOutput)
+                imgOutput->store(texelCoord, value);
+        }
+
+    private:
+        float t = 0.0f;
+        glm::ivec2 extent;
+        CpuImage* imgOutput = nullptr;
+    };
+
+    // ------------------------------------------------------------------------
+    // computeShader2.cs
+    // ------------------------------------------------------------------------
+    class LightKernel : public CpuKernel
+    {
+    public:
+        glm::uvec3 localSize() const override { return glm::uvec3(16, 16, 1); }
+
+        void prepare(const CpuUniforms& uniforms, const CpuBindings& bindings) override
+        {
+            width = uniforms.getInt("SCR_WIDTH");
+            height = uniforms.getInt("SCR_HEIGHT");
+            lightPos = uniforms.getIVec2("lightPos");
+            lightIntensity = uniforms.getFloat("lightIntensity");
+            baseColor = uniforms.getVec4("baseColor");
+            pixelOrder = uniforms.getInt("pixelOrder");
+            extent = uniforms.getIVec2("dispatchExtent");
+            outputImage = bindings.images[0];
+        }
+
+        void invoke(const CpuInvocation& inv) const override
+        {
+            glm::ivec2 coords = pixelCoords(inv, pixelGroup(inv, pixelOrder), pixelOrder);
+            if (outside(coords, extent))
+                return;
+
+            float dist = glm::length(glm::vec2(coords - lightPos));
+            float attenuation = lightIntensity / (1.0f + dist * dist * 0.01f);
+
+            glm::vec4 gradientColor(float(coords.x) / width, float(coords.y) / height, 0.5f, 1.0f);
+            float shadow = smoothstep(0.0f, 1.0f, attenuation);
+
+            glm::vec4 color = baseColor * shadow * gradientColor * attenuation;
+            if (outputImage)
+                outputImage->store(coords, color);
+        }
+
+    private:
+        int width = 0, height = 0;
+        glm::ivec2 lightPos;
+        float lightIntensity = 0.0f;
+        glm::vec4 baseColor;
+        int pixelOrder = 0;
+        glm::ivec2 extent;
+        CpuImage* outputImage = nullptr;
+    };
+
+    // ------------------------------------------------------------------------
+    // computeSh_test6.cs
+    // ------------------------------------------------------------------------
+    class CameraKernel : public CpuKernel
+    {
+    public:
+        static const int BVH_STACK_SIZE = 64;
+        static const int MAX_PROJECTED_SPHERES = 16;
+        static const int MAX_TILE_SPHERES = 256;
+        static constexpr float TILE_CONE_MARGIN = 0.01f;
+
+        glm::uvec3 localSize() const override { return glm::uvec3(16, 16, 1); }
+
+        // shared variables of the shader: the tile's sphere list
+        struct TileShared
+        {
+            unsigned int sphereCount;
+            int spheres[MAX_TILE_SPHERES];
+        };
+
+        int barrierCount() const override { return 2; }
+        std::size_t sharedSize(const glm::uvec3&) const override { return sizeof(TileShared); }
+
+        void prepare(const CpuUniforms& uniforms, const CpuBindings& bindings) override
+        {
+            outputImage = bindings.images[0];
+            accumImage = bindings.images[1];
+            extent = uniforms.getIVec2("dispatchExtent");
+            centers = (const glm::vec4*)bindings.buffers[SphereScene::CENTERS_BINDING];
+            radii = (const float*)bindings.buffers[SphereScene::RADII_BINDING];
+            nodes = (const BVHNode*)bindings.buffers[SphereBVH::NODES_BINDING];
+
+            // uniform block FrameParams of the shader
+            const FrameParams* frame = (const FrameParams*)bindings.uniformBuffers[FrameParams::BINDING];
+            FrameParams params = {};
+            if (frame)
+                params = *frame;
+            sphereCount = params.sphereCount;
+            if (!frame || !centers || !radii || !nodes)
+                sphereCount = 0;
+
+            viewMatrix = params.viewMatrix;
+            front = params.front;
+            up = params.up;
+            right = params.right;
+            cameraPos = params.cameraPos;
+            screenResolution = params.screenResolution;
+            iTime = params.iTime;
+            FOV = params.FOV;
+            showGrid = params.showGrid != 0;
+            showAxis = params.showAxis != 0;
+            tileCulling = uniforms.getBool("tileCulling");
+            pixelOrder = uniforms.getInt("pixelOrder");
+            progressive = uniforms.getBool("progressive") && accumImage;
+            overlayOnly = progressive && uniforms.getBool("overlayOnly");
+            sampleIndex = uniforms.getInt("sampleIndex");
+            sampleJitter = uniforms.getVec2("sampleJitter");
+        }
+
+        // without shared memory there is no tile list, every ray uses the BVH
+        void invoke(const CpuInvocation& inv) const override
+        {
+            shade(inv, nullptr);
+        }
+
+        void invokePhase(const CpuInvocation& inv, int phase) const override
+        {
+            TileShared& tile = *(TileShared*)inv.shared;
+            if (phase == 0) {
+                if (inv.localInvocationIndex == 0u)
+                    tile.sphereCount = 0u;
+            }
+            else if (phase == 1) {
+                if (tileCulling && !overlayOnly)
+                    addTileSpheres(inv, tile);
+            }
+            else {
+                shade(inv, &tile);
+            }
+        }
+
+    private:
+        // phase 1 of main(): this invocation's share of the spheres in the tile's cone
+        void addTileSpheres(const CpuInvocation& inv, TileShared& tile) const
+        {
+            glm::vec2 tileMin = glm::vec2(pixelGroup(inv, pixelOrder) * glm::uvec2(inv.workGroupSize));
+            glm::vec2 tileMax = tileMin + glm::vec2(inv.workGroupSize.x, inv.workGroupSize.y) - (progressive ? 0.0f : 1.0f);
+            glm::vec3 axis = rayDirection(0.5f * (tileMin + tileMax));
+            float angle = 0.0f;
+            angle = std::max(angle, std::acos(glm::clamp(glm::dot(axis, rayDirection(tileMin)), -1.0f, 1.0f)));
+            angle = std::max(angle, std::acos(glm::clamp(glm::dot(axis, rayDirection(glm::vec2(tileMax.x, tileMin.y))), -1.0f, 1.0f)));
+            angle = std::max(angle, std::acos(glm::clamp(glm::dot(axis, rayDirection(glm::vec2(tileMin.x, tileMax.y))), -1.0f, 1.0f)));
+            angle = std::max(angle, std::acos(glm::clamp(glm::dot(axis, rayDirection(tileMax)), -1.0f, 1.0f)));
+
+            int groupInvocations = (int)(inv.workGroupSize.x * inv.workGroupSize.y * inv.workGroupSize.z);
+            for (int i = (int)inv.localInvocationIndex; i < sphereCount; i += groupInvocations) {
+                if (sphereInCone(getSphere(i), cameraPos, axis, angle)) {
+                    // the phases of a workgroup run on one thread: no atomicAdd needed
+                    unsigned int slot = tile.sphereCount++;
+                    if (slot < (unsigned int)MAX_TILE_SPHERES) tile.spheres[slot] = i;
+                }
+            }
+        }
+
+        // render() of the shader: linear color of the ray, before gamma and the overlay
+        glm::vec3 render(const TileShared* tile, const glm::vec3& ro, const glm::vec3& rd) const
+        {
+            float tmin = 10000.0f;
+            glm::vec3 nor(0.0f);
+            glm::vec3 pos(0.0f);
+            glm::vec3 sur(1.0f);
+
+            int id = (tile && tileCulling && tile->sphereCount <= (unsigned int)MAX_TILE_SPHERES)
+                ? traceTileSpheres(*tile, ro, rd, tmin) : traceSpheres(ro, rd, tmin);
+            if (id >= 0) {
+                glm::vec4 sph = getSphere(id);
+                pos = ro + tmin * rd;
+                nor = glm::normalize(pos - glm::vec3(sph));
+                sur = 0.5f + 0.5f * glm::cos(float(id) * 2.0f + glm::vec3(0.0f, 2.0f, 4.0f));
+                sur *= 0.4f;
+                sur *= smoothstep(-0.6f, -0.2f, std::sin(20.0f * (pos.x - sph.x)));
+            }
+
+            float h = (-2.0f - ro.z) / rd.z;
+            if (h > 0.0f && h < tmin && showGrid) {
+                tmin = h;
+                pos = ro + h * rd;
+                nor = glm::vec3(0.0f, 0.0f, 1.0f);
+                glm::vec2 p(pos.x, pos.y);
+                sur = glm::vec3(1.0f) * gridTextureGradBox(p, p, p);
+            }
+
+            glm::vec3 col(0.0f);
+
+            if (tmin < 100.0f) {
+                pos = ro + tmin * rd;
+
+                glm::vec3 lig = glm::normalize(glm::vec3(2.0f, 1.4f, -1.0f));
+                float sha = shadowSpheres(pos, lig);
+
+                float ndl = glm::clamp(glm::dot(nor, lig), 0.0f, 1.0f);
+                float spe = std::pow(glm::clamp(glm::dot(glm::normalize(-rd + lig), nor), 0.0f, 1.0f), 16.0f);
+                col = (0.5f + 0.5f * nor.y) * glm::vec3(0.2f, 0.3f, 0.4f) + sha * glm::vec3(1.0f, 0.9f, 0.8f) * ndl + sha * glm::vec3(1.5f) * ndl * spe;
+                col *= sur;
+
+                col *= std::exp(-0.25f * std::max(0.0f, tmin - 3.0f));
+            }
+
+            return col;
+        }
+
+        // phase 2 of main(); tile is null when the kernel runs without shared memory
+        void shade(const CpuInvocation& inv, const TileShared* tile) const
+        {
+            glm::ivec2 coords = pixelCoords(inv, pixelGroup(inv, pixelOrder), pixelOrder);
+            if (outside(coords, extent))
+                return;
+            glm::vec2 uv = glm::vec2(coords) / screenResolution * 2.0f - 1.0f;
+            glm::vec2 rayUv = progressive ? uv + sampleJitter * 2.0f / screenResolution : uv;
+
+            float fov = FOV / 90.0f;
+
+            glm::vec3 ro = cameraPos;
+            glm::vec3 rd = glm::normalize(rayUv.x * right + rayUv.y * up + fov * front);
+
+            glm::vec3 col = overlayOnly ? glm::vec3(0.0f) : render(tile, ro, rd);
+
+            if (progressive) {
+                glm::vec3 sum = col;
+                if (overlayOnly)
+                    sum = glm::vec3(accumImage->load(coords));
+                else {
+                    if (sampleIndex > 0)
+                        sum += glm::vec3(accumImage->load(coords));
+                    accumImage->store(coords, glm::vec4(sum, 1.0f));
+                }
+                if (sampleIndex > 0)
+                    col = sum / float(sampleIndex + 1);
+            }
+
+            col = glm::pow(col, glm::vec3(0.45f));
+
+            for (int i = 0; i < std::min(sphereCount, MAX_PROJECTED_SPHERES); i++) {
+                ProjectionResult res = projectSphere(getSphere(i), viewMatrix, fov);
+                res.area *= screenResolution.y * screenResolution.y * 0.25f;
+                if (res.area > 0.0f) {
+                    float f = res.a * uv.x * uv.x + res.b * uv.x * uv.y + res.c * uv.y * uv.y + res.d * uv.x + res.e * uv.y + res.f;
+                    glm::vec2 g = 2.0f * glm::vec2(res.a, res.c) * uv + res.b * glm::vec2(uv.y, uv.x) + glm::vec2(res.d, res.e);
+                    float d = std::fabs(f) / glm::length(g);
+                    if (showAxis) {
+                        float showMaths = smoothstep(-0.5f, 0.5f, std::cos(0.5f * 6.2831f * iTime));
+                        col = glm::mix(col, glm::vec3(1.0f, 0.0f, 0.0f), showMaths * (1.0f - smoothstep(0.00f, 0.01f, d)));
+                        col = glm::mix(col, glm::vec3(1.0f, 1.0f, 0.0f), showMaths * (1.0f - smoothstep(0.00f, 0.01f, sdSegment(uv, -res.center - res.axisA, -res.center + res.axisA))));
+                        col = glm::mix(col, glm::vec3(1.0f, 1.0f, 0.0f), showMaths * (1.0f - smoothstep(0.00f, 0.01f, sdSegment(uv, -res.center - res.axisB, -res.center + res.axisB))));
+                        col = glm::mix(col, glm::vec3(1.0f, 0.0f, 0.0f), showMaths * (1.0f - smoothstep(0.03f, 0.04f, glm::length(uv + res.center))));
+                    }
+                    glm::vec2 pp = -res.center + 0.5f * glm::max(glm::max(res.axisA, -res.axisA), glm::max(res.axisB, -res.axisB));
+                    col = glm::mix(col, glm::vec3(1.0f), printInt((uv - pp) / 0.07f, std::floor(res.area)));
+                }
+            }
+
+            if (outputImage)
+                outputImage->store(coords, glm::vec4(col, 1.0f));
+        }
+
+        struct ProjectionResult
+        {
+            float area;
+            glm::vec2 center;
+            glm::vec2 axisA;
+            glm::vec2 axisB;
+            float a, b, c, d, e, f;
+        };
+
+        glm::vec4 getSphere(int i) const { return glm::vec4(glm::vec3(centers[i]), radii[i]); }
+
+        static ProjectionResult projectSphere(const glm::vec4& sph, const glm::mat4& cam, float fle)
+        {
+            glm::vec3 o = glm::vec3(cam * glm::vec4(glm::vec3(sph), 1.0f));
+
+            float r2 = sph.w * sph.w;
+            float z2 = o.z * o.z;
+            float l2 = glm::dot(o, o);
+
+            ProjectionResult res;
+            res.area = -3.141593f * fle * fle * r2 * std::sqrt(std::fabs((l2 - r2) / (r2 - z2))) / (r2 - z2);
+            res.axisA = fle * std::sqrt(-r2 * (r2 - l2) / ((l2 - z2) * (r2 - z2) * (r2 - z2))) * glm::vec2(o.x, o.y);
+            res.axisB = fle * std::sqrt(-r2 * (r2 - l2) / ((l2 - z2) * (r2 - z2) * (r2 - l2))) * glm::vec2(-o.y, o.x);
+            res.center = fle * o.z * glm::vec2(o.x, o.y) / (z2 - r2);
+            res.a = r2 - o.y * o.y - z2;
+            res.b = 2.0f * o.x * o.y;
+            res.c = r2 - o.x * o.x - z2;
+            res.d = -2.0f * o.x * o.z * fle;
+            res.e = -2.0f * o.y * o.z * fle;
+            res.f = (r2 - l2 + z2) * fle * fle;
+            return res;
+        }
+
+        static float sampleDigit(float n, const glm::vec2& vUV)
+        {
+            if (vUV.x < 0.0f || vUV.y < 0.0f || vUV.x >= 1.0f || vUV.y >= 1.0f)
+                return 0.0f;
+
+            float data = 0.0f;
+            if (n < 0.5f) data = 7.0f + 5.0f * 16.0f + 5.0f * 256.0f + 5.0f * 4096.0f + 7.0f * 65536.0f;
+            else if (n < 1.5f) data = 2.0f + 2.0f * 16.0f + 2.0f * 256.0f + 2.0f * 4096.0f + 2.0f * 65536.0f;
+            else if (n < 2.5f) data = 7.0f + 1.0f * 16.0f + 7.0f * 256.0f + 4.0f * 4096.0f + 7.0f * 65536.0f;
+            else if (n < 3.5f) data = 7.0f + 4.0f * 16.0f + 7.0f * 256.0f + 4.0f * 4096.0f + 7.0f * 65536.0f;
+            else if (n < 4.5f) data = 4.0f + 7.0f * 16.0f + 5.0f * 256.0f + 1.0f * 4096.0f + 1.0f * 65536.0f;
+            else if (n < 5.5f) data = 7.0f + 4.0f * 16.0f + 7.0f * 256.0f + 1.0f * 4096.0f + 7.0f * 65536.0f;
+            else if (n < 6.5f) data = 7.0f + 5.0f * 16.0f + 7.0f * 256.0f + 1.0f * 4096.0f + 7.0f * 65536.0f;
+            else if (n < 7.5f) data = 4.0f + 4.0f * 16.0f + 4.0f * 256.0f + 4.0f * 4096.0f + 7.0f * 65536.0f;
+            else if (n < 8.5f) data = 7.0f + 5.0f * 16.0f + 7.0f * 256.0f + 5.0f * 4096.0f + 7.0f * 65536.0f;
+            else if (n < 9.5f) data = 7.0f + 4.0f * 16.0f + 7.0f * 256.0f + 5.0f * 4096.0f + 7.0f * 65536.0f;
+
+            float fIndex = std::floor(vUV.x * 4.0f) + std::floor(vUV.y * 5.0f) * 4.0f;
+            return mod(std::floor(data / std::pow(2.0f, fIndex)), 2.0f);
+        }
+
+        static float printInt(const glm::vec2& uv, float value)
+        {
+            float res = 0.0f;
+            float maxDigits = 1.0f + std::ceil(std::log2(value) / std::log2(10.0f));
+            float digitID = std::floor(uv.x);
+            if (digitID > 0.0f && digitID < maxDigits) {
+                float digitVa = mod(std::floor(value / std::pow(10.0f, maxDigits - 1.0f - digitID)), 10.0f);
+                res = sampleDigit(digitVa, glm::vec2(fract(uv.x), uv.y));
+            }
+            return res;
+        }
+
+        static float iSphere(const glm::vec3& ro, const glm::vec3& rd, const glm::vec4& sph)
+        {
+            glm::vec3 oc = ro - glm::vec3(sph);
+            float b = glm::dot(oc, rd);
+            float c = glm::dot(oc, oc) - sph.w * sph.w;
+            float h = b * b - c;
+            if (h < 0.0f) return -1.0f;
+            return -b - std::sqrt(h);
+        }
+
+        static float ssSphere(const glm::vec3& ro, const glm::vec3& rd, const glm::vec4& sph)
+        {
+            glm::vec3 oc = glm::vec3(sph) - ro;
+            float b = glm::dot(oc, rd);
+
+            float res = 1.0f;
+            if (b > 0.0f) {
+                float h = glm::dot(oc, oc) - b * b - sph.w * sph.w;
+                res = smoothstep(0.0f, 1.0f, 12.0f * h / b);
+            }
+            return res;
+        }
+
+        static float iBox(const glm::vec3& ro, const glm::vec3& ird, const glm::vec3& bmin, const glm::vec3& bmax)
+        {
+            glm::vec3 t0 = (bmin - ro) * ird;
+            glm::vec3 t1 = (bmax - ro) * ird;
+            glm::vec3 tn = glm::min(t0, t1);
+            glm::vec3 tf = glm::max(t0, t1);
+            float tnear = std::max(std::max(tn.x, tn.y), tn.z);
+            float tfar = std::min(std::min(tf.x, tf.y), tf.z);
+            return (tfar >= std::max(tnear, 0.0f)) ? std::max(tnear, 0.0f) : 1e30f;
+        }
+
+        int traceSpheres(const glm::vec3& ro, const glm::vec3& rd, float& tmin) const
+        {
+            int hit = -1;
+            if (sphereCount == 0) return hit;
+
+            glm::vec3 ird = 1.0f / rd;
+            int stack[BVH_STACK_SIZE];
+            int sp = 0;
+            stack[sp++] = 0;
+
+            while (sp > 0) {
+                const BVHNode& node = nodes[stack[--sp]];
+                if (iBox(ro, ird, node.boundsMin, node.boundsMax) >= tmin) continue;
+
+                if (node.count > 0) {
+                    for (int i = node.leftFirst; i < node.leftFirst + node.count; i++) {
+                        float h = iSphere(ro, rd, getSphere(i));
+                        if (h > 0.0f && h < tmin) { tmin = h; hit = i; }
+                    }
+                }
+                else {
+                    int l = node.leftFirst;
+                    float tl = iBox(ro, ird, nodes[l].boundsMin, nodes[l].boundsMax);
+                    float tr = iBox(ro, ird, nodes[l + 1].boundsMin, nodes[l + 1].boundsMax);
+                    int nearChild = (tl <= tr) ? l : l + 1;
+                    int farChild = (tl <= tr) ? l + 1 : l;
+                    if (std::max(tl, tr) < tmin) stack[sp++] = farChild;
+                    if (std::min(tl, tr) < tmin) stack[sp++] = nearChild;
+                }
+            }
+            return hit;
+        }
+
+        glm::vec3 rayDirection(const glm::vec2& coords) const
+        {
+            glm::vec2 uv = coords / screenResolution * 2.0f - 1.0f;
+            return glm::normalize(uv.x * right + uv.y * up + FOV / 90.0f * front);
+        }
+
+        static bool sphereInCone(const glm::vec4& sph, const glm::vec3& ro, const glm::vec3& axis, float angle)
+        {
+            glm::vec3 oc = glm::vec3(sph) - ro;
+            float dist = glm::length(oc);
+            if (dist <= sph.w) return true;
+            float toCenter = std::acos(glm::clamp(glm::dot(oc, axis) / dist, -1.0f, 1.0f));
+            return toCenter <= angle + std::asin(sph.w / dist) + TILE_CONE_MARGIN;
+        }
+
+        int traceTileSpheres(const TileShared& tile, const glm::vec3& ro, const glm::vec3& rd, float& tmin) const
+        {
+            int hit = -1;
+            for (unsigned int k = 0; k < tile.sphereCount; k++) {
+                int i = tile.spheres[k];
+                float h = iSphere(ro, rd, getSphere(i));
+                if (h > 0.0f && (h < tmin || (h == tmin && i < hit))) { tmin = h; hit = i; }
+            }
+            return hit;
+        }
+
+        float shadowSpheres(const glm::vec3& ro, const glm::vec3& rd) const
+        {
+            float sha = 1.0f;
+            if (sphereCount == 0) return sha;
+
+            glm::vec3 ird = 1.0f / rd;
+            int stack[BVH_STACK_SIZE];
+            int sp = 0;
+            stack[sp++] = 0;
+
+            while (sp > 0) {
+                const BVHNode& node = nodes[stack[--sp]];
+                float margin = shadowMargin(node, ro, rd);
+                if (margin < 0.0f || iBox(ro, ird, node.boundsMin - margin, node.boundsMax + margin) >= 1e30f) continue;
+
+                if (node.count > 0) {
+                    for (int i = node.leftFirst; i < node.leftFirst + node.count; i++)
+                        sha *= ssSphere(ro, rd, getSphere(i));
+                }
+                else {
+                    stack[sp++] = node.leftFirst;
+                    stack[sp++] = node.leftFirst + 1;
+                }
+            }
+            return sha;
+        }
+
+        static float sdSegment(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b)
+        {
+            glm::vec2 pa = p - a;
+            glm::vec2 ba = b - a;
+            float h = glm::clamp(glm::dot(pa, ba) / glm::dot(ba, ba), 0.0f, 1.0f);
+            return glm::length(pa - ba * h);
+        }
+
+        static glm::vec2 calcGrad(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b, float epsilon)
+        {
+            float dx = sdSegment(p + glm::vec2(epsilon, 0.0f), a, b) - sdSegment(p - glm::vec2(epsilon, 0.0f), a, b);
+            float dy = sdSegment(p + glm::vec2(0.0f, epsilon), a, b) - sdSegment(p - glm::vec2(0.0f, epsilon), a, b);
+            return glm::vec2(dx, dy);
+        }
+
+        static float gridTextureGradBox(const glm::vec2& p, const glm::vec2& x, const glm::vec2& y)
+        {
+            const float N = 10.0f;
+            glm::vec2 grad = calcGrad(p, x, y, 0.01f);
+            glm::vec2 w = glm::abs(grad) + 0.01f;
+            glm::vec2 a = p + 0.5f * w;
+            glm::vec2 b = p - 0.5f * w;
+            glm::vec2 i = (glm::floor(a) + glm::min(glm::fract(a) * N, 1.0f) -
+                           glm::floor(b) - glm::min(glm::fract(b) * N, 1.0f)) / (N * w);
+            return (1.0f - i.x) * (1.0f - i.y);
+        }
+
+        CpuImage* outputImage = nullptr;
+        CpuImage* accumImage = nullptr;
+        glm::ivec2 extent;
+        const glm::vec4* centers = nullptr;
+        const float* radii = nullptr;
+        const BVHNode* nodes = nullptr;
+        int sphereCount = 0;
+
+        glm::mat4 viewMatrix;
+        glm::vec3 front, up, right, cameraPos;
+        glm::vec2 screenResolution;
+        float iTime = 0.0f;
+        float FOV = 45.0f;
+        bool showGrid = false;
+        bool showAxis = false;
+        bool tileCulling = false;
+        int pixelOrder = 0;
+        bool progressive = false;
+        bool overlayOnly = false;
+        int sampleIndex = 0;
+        glm::vec2 sampleJitter;
+    };
+
+    template <typename K>
+    std::unique_ptr<CpuKernel> makeKernel() { return std::unique_ptr<CpuKernel>(new K()); }
+}
+
+void registerBuiltinCpuKernels() {
+    registerCpuKernel("computeShader.cs", makeKernel<GradientKernel>);
+    registerCpuKernel("computeShader2.cs", makeKernel<LightKernel>);
+    registerCpuKernel("computeSh_test6.cs", makeKernel<CameraKernel>);
+}
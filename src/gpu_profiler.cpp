@@ -0,0 +1,160 @@
+#include "gpu_profiler.h"
+
+#include <iomanip>
+
+// name of the stage that spans beginFrame() to endFrame()
+static const char* FRAME_STAGE = "frame";
+
+void GpuProfiler::create(int framesInFlight) {
+    release();
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    enabled = bits > 0;
+    frames.assign(framesInFlight < 1 ? 1 : framesInFlight, Frame());
+    current = 0;
+    skipped = 0;
+}
+
+void GpuProfiler::release() {
+    for (Frame& frame : frames) {
+        if (!frame.queries.empty())
+            glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+    }
+    frames.clear();
+    stages.clear();
+    stageIndices.clear();
+    inFrame = false;
+    enabled = false;
+}
+
+void GpuProfiler::beginFrame() {
+    if (!enabled)
+        return;
+    // this pool was last written framesInFlight frames ago; read it before reuse
+    Frame& frame = frames[current];
+    if (frame.pending && !resolve(frame))
+        skipped++;
+    frame.used = 0;
+    frame.scopes.clear();
+    frame.pending = false;
+
+    inFrame = true;
+    frameScope = begin(FRAME_STAGE);
+}
+
+void GpuProfiler::endFrame() {
+    if (!enabled || !inFrame)
+        return;
+    end(frameScope);
+    inFrame = false;
+    frames[current].pending = true;
+    current = (current + 1) % (int)frames.size();
+}
+
+int GpuProfiler::begin(const char* stage) {
+    if (!enabled || !inFrame)
+        return -1;
+    Frame& frame = frames[current];
+    Scope scope;
+    scope.stage = stageIndex(stage);
+    scope.beginQuery = nextQuery(frame);
+    scope.endQuery = nextQuery(frame);
+    glQueryCounter(scope.beginQuery, GL_TIMESTAMP);
+    frame.scopes.push_back(scope);
+    return (int)frame.scopes.size() - 1;
+}
+
+void GpuProfiler::end(int scope) {
+    if (scope < 0 || !inFrame)
+        return;
+    glQueryCounter(frames[current].scopes[scope].endQuery, GL_TIMESTAMP);
+}
+
+GLuint GpuProfiler::nextQuery(Frame& frame) {
+    if (frame.used == (int)frame.queries.size()) {
+        GLuint query;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+    }
+    return frame.queries[frame.used++];
+}
+
+bool GpuProfiler::resolve(Frame& frame) {
+    if (frame.scopes.empty())
+        return true;
+    // the frame scope closes last; once its query is done, so are the rest
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(frame.scopes[0].endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    // a stage can open several times in one frame: add them up
+    std::vector<double> frameMs(stages.size(), -1.0);
+    for (const Scope& scope : frame.scopes) {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(scope.beginQuery, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(scope.endQuery, GL_QUERY_RESULT, &end);
+        double ms = end > begin ? (end - begin) / 1.0e6 : 0.0;
+        frameMs[scope.stage] = (frameMs[scope.stage] < 0.0 ? 0.0 : frameMs[scope.stage]) + ms;
+    }
+    for (size_t i = 0; i < frameMs.size(); i++) {
+        if (frameMs[i] < 0.0)
+            continue;
+        stages[i].last = frameMs[i];
+        stages[i].total += frameMs[i];
+        stages[i].samples++;
+    }
+    return true;
+}
+
+int GpuProfiler::stageIndex(const char* name) {
+    auto it = stageIndices.find(name);
+    if (it != stageIndices.end())
+        return it->second;
+    Stage stage;
+    stage.name = name;
+    stages.push_back(stage);
+    stageIndices.emplace(name, (int)stages.size() - 1);
+    return (int)stages.size() - 1;
+}
+
+double GpuProfiler::lastMs(const std::string& stage) const {
+    auto it = stageIndices.find(stage);
+    return it != stageIndices.end() ? stages[it->second].last : 0.0;
+}
+
+double GpuProfiler::averageMs(const std::string& stage) const {
+    auto it = stageIndices.find(stage);
+    if (it == stageIndices.end() || stages[it->second].samples == 0)
+        return 0.0;
+    return stages[it->second].total / stages[it->second].samples;
+}
+
+void GpuProfiler::print(std::ostream& out) {
+    if (!enabled) {
+        out << "GPU ms: no timestamp queries" << std::endl;
+        return;
+    }
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "GPU ms:" << std::fixed << std::setprecision(3);
+    for (const Stage& stage : stages) {
+        if (stage.name != FRAME_STAGE)
+            out << " " << stage.name << " " << (stage.samples ? stage.total / stage.samples : 0.0);
+    }
+    out << " | frame " << averageMs(FRAME_STAGE);
+    if (skipped > 0)
+        out << " (" << skipped << " frames skipped)";
+    out << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+    resetAverages();
+}
+
+void GpuProfiler::resetAverages() {
+    for (Stage& stage : stages) {
+        stage.total = 0.0;
+        stage.samples = 0;
+    }
+    skipped = 0;
+}
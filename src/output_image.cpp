@@ -0,0 +1,59 @@
+#include "output_image.h"
+
+#include <iomanip>
+
+static const ImageFormatInfo FORMATS[] = {
+    { ImageFormat::RGBA8,      GL_RGBA8,          "rgba8",          "RGBA8",      4 },
+    { ImageFormat::RGBA16F,    GL_RGBA16F,        "rgba16f",        "RGBA16F",    8 },
+    { ImageFormat::R11G11B10F, GL_R11F_G11F_B10F, "r11f_g11f_b10f", "R11G11B10F", 4 },
+    { ImageFormat::RGBA32F,    GL_RGBA32F,        "rgba32f",        "RGBA32F",    16 },
+};
+
+const ImageFormatInfo& imageFormatInfo(ImageFormat format) {
+    return FORMATS[(int)format];
+}
+
+std::string imageFormatDefines(ImageFormat format) {
+    return std::string("#define OUTPUT_FORMAT ") + imageFormatInfo(format).glsl + "\n";
+}
+
+void OutputImage::create(int width, int height, ImageFormat format, GLenum filter) {
+    release();
+    w = width;
+    h = height;
+    fmt = format;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat(), width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void OutputImage::bindImage(GLuint unit, GLenum access) const {
+    glBindImageTexture(unit, tex, 0, GL_FALSE, 0, access, internalFormat());
+}
+
+void OutputImage::release() {
+    if (tex)
+        glDeleteTextures(1, &tex);
+    tex = 0;
+}
+
+void printImageFootprint(std::ostream& out, int width, int height, double fps) {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "Output image " << width << "x" << height << " at " << fps << " FPS:" << std::endl;
+    out << std::fixed;
+    for (const ImageFormatInfo& info : FORMATS) {
+        double mb = (double)width * height * info.bytesPerPixel / (1024.0 * 1024.0);
+        double gbPerSecond = 2.0 * mb * fps / 1024.0;
+        out << "  " << std::left << std::setw(12) << info.name << std::right
+            << std::setw(3) << info.bytesPerPixel << " B/px "
+            << std::setw(8) << std::setprecision(1) << mb << " MB "
+            << std::setw(7) << std::setprecision(2) << gbPerSecond << " GB/s" << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,146 @@
+#include "pbo_readback.h"
+
+#include <chrono>
+
+namespace {
+    size_t bytesPerPixel(GLenum format, GLenum type) {
+        size_t components = 4;
+        switch (format) {
+        case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: components = 1; break;
+        case GL_RG: case GL_RG_INTEGER: components = 2; break;
+        case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+        default: break;
+        }
+        switch (type) {
+        case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: return components * 4;
+        case GL_HALF_FLOAT: case GL_SHORT: case GL_UNSIGNED_SHORT: return components * 2;
+        default: return components;
+        }
+    }
+}
+
+void PboReadback::create(int width, int height, int depth, GLenum format, GLenum type, ReadbackMode mode) {
+    release();
+    this->width = width;
+    this->height = height;
+    this->depth = depth < 1 ? 1 : depth;
+    this->format = format;
+    this->type = type;
+    bytes = (size_t)width * height * bytesPerPixel(format, type);
+
+    pbos.assign(this->depth, 0);
+    fences.assign(this->depth, nullptr);
+    glGenBuffers(this->depth, pbos.data());
+    bool persistent = mode == ReadbackMode::Persistent && GLAD_GL_ARB_buffer_storage;
+    for (GLuint pbo : pbos) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        if (persistent) {
+            GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_PACK_BUFFER, bytes, nullptr, flags);
+            mappings.push_back(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, flags));
+        }
+        else {
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    head = 0;
+    pending = 0;
+    mappedSlot = -1;
+    lastStall = totalStall = 0.0;
+    mappedFrames = 0;
+}
+
+bool PboReadback::readPixels() {
+    if (pending == depth) {
+        // the only free buffer is the one the caller is still reading from
+        if (mappedSlot >= 0)
+            return false;
+        dropOldest();
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[head]);
+    glReadPixels(0, 0, width, height, format, type, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fences[head] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    head = (head + 1) % depth;
+    pending++;
+    return true;
+}
+
+const void* PboReadback::map() {
+    if (pending < depth || mappedSlot >= 0)
+        return nullptr;
+
+    int oldest = (head - pending + depth) % depth;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (fences[oldest]) {
+        while (glClientWaitSync(fences[oldest], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fences[oldest]);
+        fences[oldest] = nullptr;
+    }
+    // coherent mapping: once the fence has signalled the copy is visible
+    const void* pixels = nullptr;
+    if (isPersistent()) {
+        pixels = mappings[oldest];
+    }
+    else {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[oldest]);
+        pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    lastStall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    totalStall += lastStall;
+    mappedFrames++;
+
+    if (!pixels) {
+        dropOldest();
+        return nullptr;
+    }
+    mappedSlot = oldest;
+    return pixels;
+}
+
+void PboReadback::unmap() {
+    if (mappedSlot < 0)
+        return;
+    if (!isPersistent()) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[mappedSlot]);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    mappedSlot = -1;
+    pending--;
+}
+
+void PboReadback::dropOldest() {
+    int oldest = (head - pending + depth) % depth;
+    if (fences[oldest])
+        glDeleteSync(fences[oldest]);
+    fences[oldest] = nullptr;
+    pending--;
+}
+
+void PboReadback::release() {
+    unmap();
+    for (GLsync& fence : fences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    for (size_t i = 0; i < mappings.size(); i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    mappings.clear();
+    if (!pbos.empty())
+        glDeleteBuffers((GLsizei)pbos.size(), pbos.data());
+    pbos.clear();
+    fences.clear();
+    pending = 0;
+}
@@ -0,0 +1,84 @@
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <filesystem>
+#include <cstdlib>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+namespace {
+    int openCounter(int tid, uint64_t config, int group) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = group < 0;    // the leader enables the whole group
+        attr.exclude_kernel = 1;      // allowed with perf_event_paranoid 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return (int)syscall(SYS_perf_event_open, &attr, tid, -1, group, PERF_FLAG_FD_CLOEXEC);
+    }
+}
+
+bool PerfCounters::create() {
+    release();
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("/proc/self/task", error)) {
+        int tid = std::atoi(entry.path().filename().c_str());
+        int leader = openCounter(tid, PERF_COUNT_HW_CACHE_REFERENCES, -1);
+        if (leader < 0)
+            continue;    // a thread that just exited, or no PMU at all
+        int member = openCounter(tid, PERF_COUNT_HW_CACHE_MISSES, leader);
+        if (member < 0) {
+            close(leader);
+            continue;
+        }
+        threads.push_back({ leader, member });
+    }
+    return available();
+}
+
+void PerfCounters::release() {
+    for (const ThreadCounters& t : threads) {
+        close(t.misses);
+        close(t.references);
+    }
+    threads.clear();
+    references = misses = 0;
+}
+
+void PerfCounters::start() {
+    for (const ThreadCounters& t : threads) {
+        ioctl(t.references, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(t.references, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+void PerfCounters::stop() {
+    references = misses = 0;
+    for (const ThreadCounters& t : threads) {
+        ioctl(t.references, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        // PERF_FORMAT_GROUP: number of counters, then their values in open order
+        uint64_t values[3] = {};
+        if (read(t.references, values, sizeof(values)) == (ssize_t)sizeof(values) && values[0] == 2) {
+            references += values[1];
+            misses += values[2];
+        }
+    }
+}
+
+#else
+
+bool PerfCounters::create() { return false; }
+void PerfCounters::release() { threads.clear(); references = misses = 0; }
+void PerfCounters::start() {}
+void PerfCounters::stop() {}
+
+#endif
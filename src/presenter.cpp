@@ -0,0 +1,184 @@
+#include "presenter.h"
+#include "program_builder.h"
+
+#include <cstring>
+#include <iostream>
+
+bool Presenter::parseMode(const char* name, PresentMode& mode) {
+    if (std::strcmp(name, "blit") == 0)
+        mode = PresentMode::Blit;
+    else if (std::strcmp(name, "quad") == 0)
+        mode = PresentMode::Quad;
+    else if (std::strcmp(name, "readback") == 0)
+        mode = PresentMode::Readback;
+    else
+        return false;
+    return true;
+}
+
+const char* Presenter::modeName(PresentMode mode) {
+    switch (mode) {
+    case PresentMode::Quad:
+        return "quad";
+    case PresentMode::Readback:
+        return "readback";
+    default:
+        return "blit";
+    }
+}
+
+bool Presenter::create(AppContext& app, PresentMode mode, int readbackDepth, ReadbackMode readbackMode) {
+    release();
+    this->app = &app;
+    presentMode = mode;
+    pboDepth = readbackDepth;
+    pboMode = readbackMode;
+    glGenFramebuffers(1, &readFramebuffer);
+
+    if (mode == PresentMode::Quad) {
+        quadProgram = ProgramBuilder::graphics("screenQuad.vs", "screenQuad.fs").get();
+        if (!quadProgram) {
+            release();
+            return false;
+        }
+        texScaleLocation = glGetUniformLocation(quadProgram, "texScale");
+        float quadVertices[] = {
+            -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+            -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+             1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+             1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+        };
+        glGenVertexArrays(1, &quadVAO);
+        glGenBuffers(1, &quadVBO);
+        glBindVertexArray(quadVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+        glBindVertexArray(0);
+    }
+    else if (mode == PresentMode::Readback && !app.isHeadless()) {
+        renderer = SDL_CreateRenderer(app.getWindow(), nullptr);
+        if (!renderer) {
+            std::cerr << "Failed to create SDL renderer: " << SDL_GetError() << std::endl;
+            release();
+            return false;
+        }
+        app.makeCurrent();
+    }
+    return true;
+}
+
+void Presenter::attach(GLuint texture) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+    if (texture != attached) {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        attached = texture;
+    }
+}
+
+void Presenter::present(GLuint texture, int width, int height) {
+    switch (presentMode) {
+    case PresentMode::Blit:
+        attach(texture);
+        blit(width, height);
+        app->swap();
+        break;
+    case PresentMode::Quad:
+        drawQuad(texture, width, height);
+        app->swap();
+        break;
+    case PresentMode::Readback:
+        attach(texture);
+        readBack(width, height);
+        break;
+    }
+}
+
+void Presenter::blit(int width, int height) {
+    int windowWidth, windowHeight;
+    app->getDrawableSize(windowWidth, windowHeight);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    GLenum filter = width == windowWidth && height == windowHeight ? GL_NEAREST : GL_LINEAR;
+    glBlitFramebuffer(0, 0, width, height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, filter);
+}
+
+void Presenter::drawQuad(GLuint texture, int width, int height) {
+    int windowWidth, windowHeight;
+    app->getDrawableSize(windowWidth, windowHeight);
+    GLint textureWidth = width, textureHeight = height;
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &textureWidth);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &textureHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, windowWidth, windowHeight);
+    glUseProgram(quadProgram);
+    // only the image part of a larger (pooled) texture is sampled
+    glUniform2f(texScaleLocation, (float)width / textureWidth, (float)height / textureHeight);
+    glBindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+}
+
+void Presenter::readBack(int width, int height) {
+    if (width != readWidth || height != readHeight) {
+        pbo.create(width, height, pboDepth, GL_RGBA, GL_UNSIGNED_BYTE, pboMode);
+        readWidth = width;
+        readHeight = height;
+        if (sdlTexture)
+            SDL_DestroyTexture(sdlTexture);
+        sdlTexture = nullptr;
+        if (renderer)
+            sdlTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, width, height);
+        else
+            cpuFrame.resize(pbo.frameBytes());
+    }
+
+    pbo.readPixels();
+    const void* pixels = pbo.map();
+    if (pixels) {
+        if (sdlTexture)
+            SDL_UpdateTexture(sdlTexture, nullptr, pixels, width * 4);
+        else
+            std::memcpy(cpuFrame.data(), pixels, cpuFrame.size());
+        pbo.unmap();
+    }
+
+    if (renderer) {
+        // glReadPixels rows go bottom to top
+        SDL_RenderClear(renderer);
+        SDL_RenderTextureRotated(renderer, sdlTexture, nullptr, nullptr, 0.0, nullptr, SDL_FLIP_VERTICAL);
+        SDL_RenderPresent(renderer);
+        // the renderer may have made its own context current
+        app->makeCurrent();
+    }
+}
+
+void Presenter::release() {
+    pbo.release();
+    readWidth = readHeight = 0;
+    cpuFrame.clear();
+    if (sdlTexture)
+        SDL_DestroyTexture(sdlTexture);
+    sdlTexture = nullptr;
+    if (renderer)
+        SDL_DestroyRenderer(renderer);
+    renderer = nullptr;
+
+    if (quadVAO) {
+        glDeleteVertexArrays(1, &quadVAO);
+        glDeleteBuffers(1, &quadVBO);
+    }
+    quadVAO = quadVBO = 0;
+    if (quadProgram)
+        glDeleteProgram(quadProgram);
+    quadProgram = 0;
+    if (readFramebuffer)
+        glDeleteFramebuffers(1, &readFramebuffer);
+    readFramebuffer = 0;
+    attached = 0;
+}
@@ -0,0 +1,152 @@
+#include "program_builder.h"
+#include "program_cache.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static std::string readSource(const char* path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+        return "";
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+// #version has to stay the first line, so the prelude goes after it
+static std::string withDefines(const std::string& source, const std::string& defines) {
+    if (defines.empty())
+        return source;
+    size_t line = 0;
+    if (source.compare(0, 8, "#version") == 0) {
+        line = source.find('\n');
+        line = line == std::string::npos ? source.size() : line + 1;
+    }
+    return source.substr(0, line) + defines + source.substr(line);
+}
+
+// let the driver use as many compiler threads as it likes; once per context
+static void enableCompilerThreads() {
+    static bool enabled = false;
+    if (!enabled && GLAD_GL_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        enabled = true;
+    }
+}
+
+static GLuint submitShader(GLenum type, const std::string& source) {
+    const char* code = source.c_str();
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &code, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+bool ProgramBuilder::isParallel() {
+    return GLAD_GL_KHR_parallel_shader_compile != 0;
+}
+
+ProgramFuture ProgramBuilder::compute(const char* computePath, const std::string& defines) {
+    ProgramFuture future;
+    future.state = std::make_shared<ProgramFuture::State>();
+    ProgramFuture::State& state = *future.state;
+    state.cacheSource = withDefines(readSource(computePath), defines);
+    state.defines = defines;
+
+    state.program = ProgramCache::global().load(state.cacheSource);
+    if (state.program) {
+        state.finished = true;
+        state.linked = true;
+        return future;
+    }
+    enableCompilerThreads();
+    state.shaders.push_back(submitShader(GL_COMPUTE_SHADER, state.cacheSource));
+    state.stages.push_back("COMPUTE");
+    state.program = glCreateProgram();
+    glProgramParameteri(state.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(state.program, state.shaders[0]);
+    glLinkProgram(state.program);
+    return future;
+}
+
+ProgramFuture ProgramBuilder::graphics(const char* vertexPath, const char* fragmentPath, const char* geometryPath) {
+    ProgramFuture future;
+    future.state = std::make_shared<ProgramFuture::State>();
+    ProgramFuture::State& state = *future.state;
+    enableCompilerThreads();
+
+    state.shaders.push_back(submitShader(GL_VERTEX_SHADER, readSource(vertexPath)));
+    state.stages.push_back("VERTEX");
+    state.shaders.push_back(submitShader(GL_FRAGMENT_SHADER, readSource(fragmentPath)));
+    state.stages.push_back("FRAGMENT");
+    if (geometryPath != nullptr) {
+        state.shaders.push_back(submitShader(GL_GEOMETRY_SHADER, readSource(geometryPath)));
+        state.stages.push_back("GEOMETRY");
+    }
+    state.program = glCreateProgram();
+    for (GLuint shader : state.shaders)
+        glAttachShader(state.program, shader);
+    glLinkProgram(state.program);
+    return future;
+}
+
+void ProgramBuilder::finishAll(std::vector<ProgramFuture>& futures) {
+    for (ProgramFuture& future : futures)
+        future.get();
+}
+
+const std::string& ProgramFuture::defines() const {
+    static const std::string none;
+    return state ? state->defines : none;
+}
+
+bool ProgramFuture::ready() const {
+    if (!state)
+        return false;
+    if (state->finished || !GLAD_GL_KHR_parallel_shader_compile)
+        return true;
+    GLint done = GL_FALSE;
+    glGetProgramiv(state->program, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+GLuint ProgramFuture::get() {
+    if (!state)
+        return 0;
+    if (state->finished)
+        return state->linked ? state->program : 0;
+
+    GLchar infoLog[1024];
+    for (size_t i = 0; i < state->shaders.size(); i++) {
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(state->shaders[i], GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            glGetShaderInfoLog(state->shaders[i], 1024, NULL, infoLog);
+            std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << state->stages[i] << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+        }
+    }
+    GLint linked = GL_FALSE;
+    glGetProgramiv(state->program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        glGetProgramInfoLog(state->program, 1024, NULL, infoLog);
+        std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: PROGRAM\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+    }
+    for (GLuint shader : state->shaders) {
+        glDetachShader(state->program, shader);
+        glDeleteShader(shader);
+    }
+    state->shaders.clear();
+    if (linked && !state->cacheSource.empty())
+        ProgramCache::global().store(state->cacheSource, state->program);
+    state->cacheSource.clear();
+    if (!linked) {
+        glDeleteProgram(state->program);
+        state->program = 0;
+    }
+    state->finished = true;
+    state->linked = linked == GL_TRUE;
+    return state->linked ? state->program : 0;
+}
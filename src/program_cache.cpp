@@ -0,0 +1,162 @@
+#include "program_cache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+// first bytes of every entry; bump the digit when the layout changes
+static const char ENTRY_MAGIC[8] = { 'C', 'S', 'P', 'B', 'I', 'N', '0', '1' };
+
+static std::uint64_t fnv1a(const std::string& text, std::uint64_t hash = 14695981039346656037ull) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::string glString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? (const char*)value : "";
+}
+
+ProgramCache& ProgramCache::global() {
+    static ProgramCache cache;
+    return cache;
+}
+
+ProgramCache::ProgramCache() : directory("program_cache") {
+    if (const char* setting = std::getenv("CS_PROGRAM_CACHE")) {
+        if (std::strcmp(setting, "off") == 0 || std::strcmp(setting, "0") == 0)
+            enabled = false;
+        else if (*setting)
+            directory = setting;
+    }
+}
+
+bool ProgramCache::isEnabled() const {
+    if (!enabled)
+        return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+std::string ProgramCache::driverKey() const {
+    return glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+}
+
+std::string ProgramCache::entryPath(const std::string& key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)fnv1a(key));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+// Entry layout: magic, key length, key, binary format, binary length, binary.
+// The key is the driver strings plus the source hash, so a hash collision of
+// the file name alone still misses.
+GLuint ProgramCache::load(const std::string& source) {
+    if (!isEnabled())
+        return 0;
+    std::string key = driverKey() + '\n' + std::to_string(fnv1a(source));
+    std::string path = entryPath(key);
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        missCount++;
+        return 0;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    size_t offset = 0;
+    auto read = [&](void* out, size_t size) {
+        if (offset + size > data.size())
+            return false;
+        std::memcpy(out, data.data() + offset, size);
+        offset += size;
+        return true;
+    };
+    char magic[sizeof(ENTRY_MAGIC)];
+    std::uint32_t keyLength = 0, format = 0, length = 0;
+    bool valid = read(magic, sizeof(magic)) && std::memcmp(magic, ENTRY_MAGIC, sizeof(magic)) == 0
+        && read(&keyLength, sizeof(keyLength)) && keyLength == key.size()
+        && offset + keyLength <= data.size() && key.compare(0, keyLength, data.data() + offset, keyLength) == 0;
+    offset += keyLength;
+    valid = valid && read(&format, sizeof(format)) && read(&length, sizeof(length)) && offset + length == data.size();
+
+    GLuint program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        glProgramBinary(program, format, data.data() + offset, (GLsizei)length);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    if (!program) {
+        // stale or damaged: drop it so the next store() replaces it
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        missCount++;
+        return 0;
+    }
+    hitCount++;
+    return program;
+}
+
+void ProgramCache::store(const std::string& source, GLuint program) {
+    if (!isEnabled())
+        return;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::string key = driverKey() + '\n' + std::to_string(fnv1a(source));
+    std::string path = entryPath(key);
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    // write next to the entry and rename over it, which is atomic on one file system
+    std::string temporary = path + ".tmp" + std::to_string((long long)getpid());
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return;
+        std::uint32_t keyLength = (std::uint32_t)key.size();
+        std::uint32_t binaryFormat = format;
+        std::uint32_t binaryLength = (std::uint32_t)length;
+        file.write(ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+        file.write((const char*)&keyLength, sizeof(keyLength));
+        file.write(key.data(), key.size());
+        file.write((const char*)&binaryFormat, sizeof(binaryFormat));
+        file.write((const char*)&binaryLength, sizeof(binaryLength));
+        file.write(binary.data(), length);
+        if (!file) {
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+        std::filesystem::remove(temporary, error);
+}
@@ -0,0 +1,239 @@
+#include "ray_packet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RAY_PACKET_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang need the ISA enabled per function; MSVC allows the intrinsics anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define RAY_PACKET_TARGET(isa) __attribute__((target(isa)))
+#else
+#define RAY_PACKET_TARGET(isa)
+#endif
+
+namespace {
+    // same light as renderImage in test7_secuencial.cpp
+    const glm::vec3 LIGHT_DIR = glm::normalize(glm::vec3(2.0f, 1.4f, -1.0f));
+    const float LIGHT_X = LIGHT_DIR.x;
+    const float LIGHT_Y = LIGHT_DIR.y;
+    const float LIGHT_Z = LIGHT_DIR.z;
+
+    typedef void (*PacketKernel)(RayPacket&, const glm::vec3&, const SphereSceneView&, int, int);
+
+    void tracePacketScalar(RayPacket& p, const glm::vec3& ro, const SphereSceneView& spheres, int first, int last) {
+        for (int i = first; i < last; i++) {
+            // the origin is shared by the whole packet, so oc and c are per sphere
+            float ocx = ro.x - spheres.centerX[i];
+            float ocy = ro.y - spheres.centerY[i];
+            float ocz = ro.z - spheres.centerZ[i];
+            float c = ocx * ocx + ocy * ocy + ocz * ocz - spheres.radius[i] * spheres.radius[i];
+
+            for (int k = 0; k < p.count; k++) {
+                float b = ocx * p.dirX[k] + ocy * p.dirY[k] + ocz * p.dirZ[k];
+                float h = b * b - c;
+                if (h < 0.0f) continue;
+                float t = -b - std::sqrt(h);
+                if (t <= 0.0f || t >= p.tmin[k]) continue;
+
+                p.tmin[k] = t;
+                float nx = ocx + t * p.dirX[k];
+                float ny = ocy + t * p.dirY[k];
+                float nz = ocz + t * p.dirZ[k];
+                float inv = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+                float ndl = std::max((nx * LIGHT_X + ny * LIGHT_Y + nz * LIGHT_Z) * inv, 0.0f);
+                p.colR[k] = p.colR[k] * 0.5f + 1.0f * ndl * 0.5f;
+                p.colG[k] = p.colG[k] * 0.5f + 0.9f * ndl * 0.5f;
+                p.colB[k] = p.colB[k] * 0.5f + 0.8f * ndl * 0.5f;
+            }
+        }
+    }
+
+#ifdef RAY_PACKET_X86
+    RAY_PACKET_TARGET("avx2")
+    void tracePacketAVX2(RayPacket& p, const glm::vec3& ro, const SphereSceneView& spheres, int first, int last) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 lx = _mm256_set1_ps(LIGHT_X), ly = _mm256_set1_ps(LIGHT_Y), lz = _mm256_set1_ps(LIGHT_Z);
+        const __m256 kr = _mm256_set1_ps(1.0f * 0.5f), kg = _mm256_set1_ps(0.9f * 0.5f), kb = _mm256_set1_ps(0.8f * 0.5f);
+
+        for (int k = 0; k < p.count; k += 8) {
+            __m256 dx = _mm256_load_ps(p.dirX + k);
+            __m256 dy = _mm256_load_ps(p.dirY + k);
+            __m256 dz = _mm256_load_ps(p.dirZ + k);
+            __m256 tmin = _mm256_load_ps(p.tmin + k);
+            __m256 cr = _mm256_load_ps(p.colR + k);
+            __m256 cg = _mm256_load_ps(p.colG + k);
+            __m256 cb = _mm256_load_ps(p.colB + k);
+
+            for (int i = first; i < last; i++) {
+                float sx = ro.x - spheres.centerX[i], sy = ro.y - spheres.centerY[i], sz = ro.z - spheres.centerZ[i];
+                __m256 ocx = _mm256_set1_ps(sx), ocy = _mm256_set1_ps(sy), ocz = _mm256_set1_ps(sz);
+                __m256 c = _mm256_set1_ps(sx * sx + sy * sy + sz * sz - spheres.radius[i] * spheres.radius[i]);
+
+                __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, dx), _mm256_mul_ps(ocy, dy)), _mm256_mul_ps(ocz, dz));
+                __m256 h = _mm256_sub_ps(_mm256_mul_ps(b, b), c);
+                __m256 hit = _mm256_cmp_ps(h, zero, _CMP_GE_OQ);
+                if (_mm256_movemask_ps(hit) == 0) continue;
+
+                __m256 t = _mm256_sub_ps(_mm256_sub_ps(zero, b), _mm256_sqrt_ps(_mm256_max_ps(h, zero)));
+                hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+                hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, tmin, _CMP_LT_OQ));
+                if (_mm256_movemask_ps(hit) == 0) continue;
+
+                tmin = _mm256_blendv_ps(tmin, t, hit);
+                __m256 nx = _mm256_add_ps(ocx, _mm256_mul_ps(t, dx));
+                __m256 ny = _mm256_add_ps(ocy, _mm256_mul_ps(t, dy));
+                __m256 nz = _mm256_add_ps(ocz, _mm256_mul_ps(t, dz));
+                __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz));
+                __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(len2));
+                __m256 ndl = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, lx), _mm256_mul_ps(ny, ly)), _mm256_mul_ps(nz, lz));
+                ndl = _mm256_max_ps(_mm256_mul_ps(ndl, inv), zero);
+
+                cr = _mm256_blendv_ps(cr, _mm256_add_ps(_mm256_mul_ps(cr, half), _mm256_mul_ps(kr, ndl)), hit);
+                cg = _mm256_blendv_ps(cg, _mm256_add_ps(_mm256_mul_ps(cg, half), _mm256_mul_ps(kg, ndl)), hit);
+                cb = _mm256_blendv_ps(cb, _mm256_add_ps(_mm256_mul_ps(cb, half), _mm256_mul_ps(kb, ndl)), hit);
+            }
+
+            _mm256_store_ps(p.tmin + k, tmin);
+            _mm256_store_ps(p.colR + k, cr);
+            _mm256_store_ps(p.colG + k, cg);
+            _mm256_store_ps(p.colB + k, cb);
+        }
+    }
+
+    RAY_PACKET_TARGET("avx512f")
+    void tracePacketAVX512(RayPacket& p, const glm::vec3& ro, const SphereSceneView& spheres, int first, int last) {
+        const __m512 zero = _mm512_setzero_ps();
+        const __m512 one = _mm512_set1_ps(1.0f);
+        const __m512 half = _mm512_set1_ps(0.5f);
+        const __m512 lx = _mm512_set1_ps(LIGHT_X), ly = _mm512_set1_ps(LIGHT_Y), lz = _mm512_set1_ps(LIGHT_Z);
+        const __m512 kr = _mm512_set1_ps(1.0f * 0.5f), kg = _mm512_set1_ps(0.9f * 0.5f), kb = _mm512_set1_ps(0.8f * 0.5f);
+
+        for (int k = 0; k < p.count; k += 16) {
+            __m512 dx = _mm512_load_ps(p.dirX + k);
+            __m512 dy = _mm512_load_ps(p.dirY + k);
+            __m512 dz = _mm512_load_ps(p.dirZ + k);
+            __m512 tmin = _mm512_load_ps(p.tmin + k);
+            __m512 cr = _mm512_load_ps(p.colR + k);
+            __m512 cg = _mm512_load_ps(p.colG + k);
+            __m512 cb = _mm512_load_ps(p.colB + k);
+
+            for (int i = first; i < last; i++) {
+                float sx = ro.x - spheres.centerX[i], sy = ro.y - spheres.centerY[i], sz = ro.z - spheres.centerZ[i];
+                __m512 ocx = _mm512_set1_ps(sx), ocy = _mm512_set1_ps(sy), ocz = _mm512_set1_ps(sz);
+                __m512 c = _mm512_set1_ps(sx * sx + sy * sy + sz * sz - spheres.radius[i] * spheres.radius[i]);
+
+                __m512 b = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(ocx, dx), _mm512_mul_ps(ocy, dy)), _mm512_mul_ps(ocz, dz));
+                __m512 h = _mm512_sub_ps(_mm512_mul_ps(b, b), c);
+                __mmask16 hit = _mm512_cmp_ps_mask(h, zero, _CMP_GE_OQ);
+                if (hit == 0) continue;
+
+                __m512 t = _mm512_sub_ps(_mm512_sub_ps(zero, b), _mm512_sqrt_ps(_mm512_max_ps(h, zero)));
+                hit = _mm512_mask_cmp_ps_mask(hit, t, zero, _CMP_GT_OQ);
+                hit = _mm512_mask_cmp_ps_mask(hit, t, tmin, _CMP_LT_OQ);
+                if (hit == 0) continue;
+
+                tmin = _mm512_mask_blend_ps(hit, tmin, t);
+                __m512 nx = _mm512_add_ps(ocx, _mm512_mul_ps(t, dx));
+                __m512 ny = _mm512_add_ps(ocy, _mm512_mul_ps(t, dy));
+                __m512 nz = _mm512_add_ps(ocz, _mm512_mul_ps(t, dz));
+                __m512 len2 = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(nx, nx), _mm512_mul_ps(ny, ny)), _mm512_mul_ps(nz, nz));
+                __m512 inv = _mm512_div_ps(one, _mm512_sqrt_ps(len2));
+                __m512 ndl = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(nx, lx), _mm512_mul_ps(ny, ly)), _mm512_mul_ps(nz, lz));
+                ndl = _mm512_max_ps(_mm512_mul_ps(ndl, inv), zero);
+
+                cr = _mm512_mask_blend_ps(hit, cr, _mm512_add_ps(_mm512_mul_ps(cr, half), _mm512_mul_ps(kr, ndl)));
+                cg = _mm512_mask_blend_ps(hit, cg, _mm512_add_ps(_mm512_mul_ps(cg, half), _mm512_mul_ps(kg, ndl)));
+                cb = _mm512_mask_blend_ps(hit, cb, _mm512_add_ps(_mm512_mul_ps(cb, half), _mm512_mul_ps(kb, ndl)));
+            }
+
+            _mm512_store_ps(p.tmin + k, tmin);
+            _mm512_store_ps(p.colR + k, cr);
+            _mm512_store_ps(p.colG + k, cg);
+            _mm512_store_ps(p.colB + k, cb);
+        }
+    }
+
+    bool cpuHasAVX2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    bool cpuHasAVX512() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0xe6) != 0xe6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 16)) != 0;
+#else
+        return __builtin_cpu_supports("avx512f");
+#endif
+    }
+#endif
+
+    struct KernelChoice
+    {
+        PacketKernel kernel;
+        const char* name;
+    };
+
+    KernelChoice pickKernel() {
+        const char* cap = std::getenv("RAY_PACKET_ISA");
+        bool allow512 = !cap || std::strcmp(cap, "avx512") == 0;
+        bool allow256 = allow512 || std::strcmp(cap, "avx2") == 0;
+#ifdef RAY_PACKET_X86
+        if (allow512 && cpuHasAVX512()) return { tracePacketAVX512, "avx512" };
+        if (allow256 && cpuHasAVX2()) return { tracePacketAVX2, "avx2" };
+#else
+        (void)allow256;
+#endif
+        return { tracePacketScalar, "scalar" };
+    }
+
+    const KernelChoice& kernelChoice() {
+        static const KernelChoice choice = pickKernel();
+        return choice;
+    }
+}
+
+void RayPacket::reset(int rayCount) {
+    count = rayCount;
+    for (int k = 0; k < MAX_RAYS; k++) {
+        if (k >= rayCount)
+            dirX[k] = dirY[k] = dirZ[k] = 0.0f;
+        tmin[k] = 10000.0f;
+        colR[k] = colG[k] = colB[k] = 0.0f;
+    }
+}
+
+void tracePacket(RayPacket& packet, const glm::vec3& ro, const SphereSceneView& spheres, int first, int last) {
+    kernelChoice().kernel(packet, ro, spheres, first, last);
+}
+
+const char* rayPacketKernelName() {
+    return kernelChoice().name;
+}
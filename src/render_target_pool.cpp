@@ -0,0 +1,116 @@
+#include "render_target_pool.h"
+
+#include <algorithm>
+
+GLuint RenderTargetPool::acquire(GLenum format, int width, int height) {
+    int allocWidth = roundUp(std::max(1, width));
+    int allocHeight = roundUp(std::max(1, height));
+
+    for (Entry& entry : entries) {
+        if (!entry.inUse && entry.format == format && entry.width == allocWidth && entry.height == allocHeight) {
+            entry.inUse = true;
+            return entry.texture;
+        }
+    }
+
+    Entry entry = { 0, format, allocWidth, allocHeight, true, 0 };
+    glGenTextures(1, &entry.texture);
+    glBindTexture(GL_TEXTURE_2D, entry.texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, format, allocWidth, allocHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    entries.push_back(entry);
+    allocationCount++;
+    return entry.texture;
+}
+
+void RenderTargetPool::recycle(GLuint texture) {
+    for (Entry& entry : entries) {
+        if (entry.texture == texture && entry.inUse) {
+            entry.inUse = false;
+            entry.releasedAt = releaseCounter++;
+        }
+    }
+
+    // drop the idle textures released longest ago
+    for (;;) {
+        int idle = 0;
+        auto oldest = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->inUse)
+                continue;
+            idle++;
+            if (oldest == entries.end() || it->releasedAt < oldest->releasedAt)
+                oldest = it;
+        }
+        if (idle <= MAX_IDLE)
+            break;
+        glDeleteTextures(1, &oldest->texture);
+        entries.erase(oldest);
+    }
+}
+
+void RenderTargetPool::release() {
+    for (Entry& entry : entries)
+        glDeleteTextures(1, &entry.texture);
+    entries.clear();
+}
+
+const RenderTargetPool::Entry* RenderTargetPool::find(GLuint texture) const {
+    for (const Entry& entry : entries) {
+        if (entry.texture == texture)
+            return &entry;
+    }
+    return nullptr;
+}
+
+int RenderTargetPool::allocatedWidth(GLuint texture) const {
+    const Entry* entry = find(texture);
+    return entry ? entry->width : 0;
+}
+
+int RenderTargetPool::allocatedHeight(GLuint texture) const {
+    const Entry* entry = find(texture);
+    return entry ? entry->height : 0;
+}
+
+void RenderTarget::create(RenderTargetPool& pool, GLenum format, int width, int height) {
+    release();
+    this->pool = &pool;
+    internalFormat = format;
+    w = std::max(1, width);
+    h = std::max(1, height);
+    tex = pool.acquire(format, w, h);
+}
+
+bool RenderTarget::resize(int width, int height) {
+    width = std::max(1, width);
+    height = std::max(1, height);
+    if (!pool || (width == w && height == h))
+        return false;
+    w = width;
+    h = height;
+
+    // keep the texture while the image fits and uses at least a quarter of
+    // it, so dragging a window edge does not allocate on every event
+    int allocWidth = pool->allocatedWidth(tex);
+    int allocHeight = pool->allocatedHeight(tex);
+    bool fits = width <= allocWidth && height <= allocHeight;
+    bool wasteful = (long long)width * height * 4 < (long long)allocWidth * allocHeight;
+    if (fits && !wasteful)
+        return false;
+
+    GLuint previous = tex;
+    tex = pool->acquire(internalFormat, width, height);
+    pool->recycle(previous);
+    return tex != previous;
+}
+
+void RenderTarget::release() {
+    if (pool && tex)
+        pool->recycle(tex);
+    pool = nullptr;
+    tex = 0;
+}
@@ -0,0 +1,112 @@
+#include "shader_watcher.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// "a|b|c", set from SHADER_FILES by the root CMakeLists.txt
+#ifndef CS_SHADER_FILES
+#define CS_SHADER_FILES ""
+#endif
+
+std::vector<std::string> ShaderWatcher::sourceFiles() {
+    std::vector<std::string> result;
+    std::string list = CS_SHADER_FILES;
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find('|', start);
+        if (end == std::string::npos)
+            end = list.size();
+        if (end > start)
+            result.push_back(list.substr(start, end - start));
+        start = end + 1;
+    }
+    return result;
+}
+
+std::string ShaderWatcher::sourcePath(const std::string& name) {
+    for (const std::string& file : sourceFiles()) {
+        if (std::filesystem::path(file).filename() == name && std::filesystem::exists(file))
+            return file;
+    }
+    return name;
+}
+
+#ifdef __linux__
+
+bool ShaderWatcher::create(const std::vector<std::string>& files) {
+    release();
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        return false;
+    for (const std::string& file : files) {
+        std::filesystem::path path = std::filesystem::absolute(file);
+        std::string directory = path.parent_path().string();
+        this->files.push_back(path.string());
+        bool known = std::any_of(watches.begin(), watches.end(),
+                                 [&](const Watch& w) { return w.directory == directory; });
+        if (known)
+            continue;
+        int descriptor = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (descriptor >= 0)
+            watches.push_back({ descriptor, directory });
+    }
+    return !watches.empty();
+}
+
+void ShaderWatcher::release() {
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+    watches.clear();
+    files.clear();
+}
+
+std::vector<std::string> ShaderWatcher::poll() {
+    std::vector<std::string> changed;
+    if (fd < 0)
+        return changed;
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;    // EAGAIN: nothing left
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = (const inotify_event*)(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->len == 0)
+                continue;
+            auto watch = std::find_if(watches.begin(), watches.end(),
+                                      [&](const Watch& w) { return w.descriptor == event->wd; });
+            if (watch == watches.end())
+                continue;
+            std::string path = (std::filesystem::path(watch->directory) / event->name).string();
+            bool watched = std::find(files.begin(), files.end(), path) != files.end();
+            if (watched && std::find(changed.begin(), changed.end(), path) == changed.end())
+                changed.push_back(path);
+        }
+    }
+    return changed;
+}
+
+#else
+
+bool ShaderWatcher::create(const std::vector<std::string>& files) {
+    release();
+    this->files = files;
+    return false;
+}
+
+void ShaderWatcher::release() {
+    files.clear();
+}
+
+std::vector<std::string> ShaderWatcher::poll() {
+    return {};
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "sphere_scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+
+void SphereScene::add(const glm::vec3& center, float r) {
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    radius.push_back(r);
+}
+
+void SphereScene::set(int i, const glm::vec4& sphere) {
+    centerX[i] = sphere.x;
+    centerY[i] = sphere.y;
+    centerZ[i] = sphere.z;
+    radius[i] = sphere.w;
+}
+
+void SphereScene::reserve(int count) {
+    centerX.reserve(count);
+    centerY.reserve(count);
+    centerZ.reserve(count);
+    radius.reserve(count);
+}
+
+void SphereScene::clear() {
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    radius.clear();
+}
+
+SphereSceneView SphereScene::view() const {
+    return { centerX.data(), centerY.data(), centerZ.data(), radius.data(), size() };
+}
+
+SphereScene SphereScene::defaultScene() {
+    SphereScene scene;
+    scene.add(glm::vec4(-2.0f, 1.0f, 0.0f, 1.1f));
+    scene.add(glm::vec4( 3.0f, 1.5f, 1.0f, 1.2f));
+    scene.add(glm::vec4( 1.0f,-1.0f, 1.0f, 1.3f));
+    return scene;
+}
+
+SphereScene SphereScene::random(int count, unsigned int seed) {
+    // keep the density roughly constant: the box side grows with cbrt(count)
+    float extent = 4.0f * std::cbrt((float)std::max(count, 1));
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> xy(-extent, extent);
+    std::uniform_real_distribution<float> z(-1.0f, extent);
+    std::uniform_real_distribution<float> r(0.2f, 0.6f);
+
+    SphereScene scene;
+    scene.reserve(count);
+    for (int i = 0; i < count; i++) {
+        float x = xy(rng);
+        float y = xy(rng);
+        float zz = z(rng);
+        scene.add(glm::vec3(x, y, zz), r(rng));
+    }
+    return scene;
+}
+
+SphereScene::SphereScene(SphereScene&& other) noexcept {
+    *this = std::move(other);
+}
+
+SphereScene& SphereScene::operator=(SphereScene&& other) noexcept {
+    if (this == &other)
+        return *this;
+    release();
+    centerX = std::move(other.centerX);
+    centerY = std::move(other.centerY);
+    centerZ = std::move(other.centerZ);
+    radius = std::move(other.radius);
+    centersBuffer = std::exchange(other.centersBuffer, 0);
+    radiiBuffer = std::exchange(other.radiiBuffer, 0);
+    gpuCapacity = std::exchange(other.gpuCapacity, 0);
+    return *this;
+}
+
+void SphereScene::upload() {
+    int count = size();
+    // std430 pads vec3 to 16 bytes, so the centers are repacked as vec4
+    std::vector<glm::vec4> centers(count);
+    for (int i = 0; i < count; i++)
+        centers[i] = glm::vec4(centerX[i], centerY[i], centerZ[i], 1.0f);
+
+    if (centersBuffer == 0) {
+        glGenBuffers(1, &centersBuffer);
+        glGenBuffers(1, &radiiBuffer);
+    }
+
+    // an empty SSBO binding is not allowed, keep at least one element around
+    int capacity = std::max(count, 1);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, centersBuffer);
+    if (capacity > gpuCapacity)
+        glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(glm::vec4), nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(glm::vec4), centers.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, radiiBuffer);
+    if (capacity > gpuCapacity)
+        glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(float), nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(float), radius.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    gpuCapacity = std::max(gpuCapacity, capacity);
+    bind();
+}
+
+void SphereScene::bind() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CENTERS_BINDING, centersBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, RADII_BINDING, radiiBuffer);
+}
+
+void SphereScene::release() {
+    if (centersBuffer != 0) {
+        glDeleteBuffers(1, &centersBuffer);
+        glDeleteBuffers(1, &radiiBuffer);
+    }
+    centersBuffer = radiiBuffer = 0;
+    gpuCapacity = 0;
+}
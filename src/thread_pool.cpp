@@ -0,0 +1,136 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace {
+    // pool/worker the current thread belongs to, so nested parallelFor calls
+    // made from inside a task can keep draining their own deque
+    thread_local const ThreadPool* tlsPool = nullptr;
+    thread_local unsigned int tlsWorker = 0;
+}
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < threadCount; i++)
+        workers.push_back(std::make_unique<Worker>());
+    for (unsigned int i = 0; i < threadCount; i++)
+        workers[i]->thread = std::thread(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCv.notify_all();
+    for (auto& worker : workers)
+        worker->thread.join();
+}
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::submit(Task task) {
+    unsigned int index;
+    if (tlsPool == this)
+        index = tlsWorker; // keep spawned work local, idle workers will steal it
+    else
+        index = nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    {
+        // taking the lock orders the push against a worker about to sleep
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCv.notify_one();
+}
+
+bool ThreadPool::popLocal(unsigned int index, Task& task) {
+    Worker& worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty())
+        return false;
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::steal(unsigned int thief, Task& task) {
+    unsigned int n = size();
+    for (unsigned int k = 1; k <= n; k++) {
+        Worker& victim = *workers[(thief + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty())
+            continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned int index) {
+    tlsPool = this;
+    tlsWorker = index;
+
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCv.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping && queued.load() == 0)
+            return;
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& fn) {
+    if (count <= 0)
+        return;
+
+    struct Batch
+    {
+        std::atomic<int> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    // shared so the last task may still touch it after the caller returned
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = count;
+
+    for (int i = 0; i < count; i++) {
+        submit([batch, &fn, i] {
+            fn(i);
+            if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                batch->done.notify_all();
+            }
+        });
+    }
+
+    // help instead of idling; a worker that issued a nested parallelFor must
+    // keep running tasks or the pool could run out of free threads
+    unsigned int self = (tlsPool == this) ? tlsWorker : 0;
+    while (batch->remaining.load(std::memory_order_acquire) > 0) {
+        Task task;
+        if ((tlsPool == this && popLocal(self, task)) || steal(self, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->done.wait(lock, [&batch] { return batch->remaining.load(std::memory_order_acquire) == 0; });
+    }
+}
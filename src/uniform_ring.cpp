@@ -0,0 +1,89 @@
+#include "uniform_ring.h"
+
+#include <cstring>
+
+void UniformRing::create(GLuint binding, size_t blockSize, int slotsPerFrame, int framesInFlight) {
+    release();
+    this->binding = binding;
+    this->blockSize = blockSize;
+    this->slotsPerFrame = slotsPerFrame;
+    this->framesInFlight = framesInFlight;
+
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    stride = (blockSize + alignment - 1) / alignment * alignment;
+    GLsizeiptr size = (GLsizeiptr)(stride * slotsPerFrame * framesInFlight);
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    if (GLAD_GL_ARB_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+        mapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags);
+    }
+    else {
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    fences.assign(framesInFlight, nullptr);
+    region = 0;
+    slot = 0;
+}
+
+void UniformRing::write(const void* block) {
+    // more dispatches than slotsPerFrame: carry on in the next region
+    if (slot == slotsPerFrame)
+        endFrame();
+    if (slot == 0)
+        waitRegion(region);
+
+    GLintptr offset = (GLintptr)((region * slotsPerFrame + slot) * stride);
+    if (mapped) {
+        std::memcpy(mapped + offset, block, blockSize);
+    }
+    else {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, blockSize, block);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, blockSize);
+    slot++;
+}
+
+void UniformRing::endFrame() {
+    if (slot == 0)
+        return;
+    // glBufferSubData is ordered by the driver, only mapped writes need a fence
+    if (mapped)
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % framesInFlight;
+    slot = 0;
+}
+
+void UniformRing::waitRegion(int r) {
+    if (!fences[r])
+        return;
+    while (glClientWaitSync(fences[r], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fences[r]);
+    fences[r] = nullptr;
+}
+
+void UniformRing::release() {
+    for (GLsync& fence : fences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (buffer != 0) {
+        if (mapped) {
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+    buffer = 0;
+    mapped = nullptr;
+}
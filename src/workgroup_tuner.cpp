@@ -0,0 +1,170 @@
+#include "workgroup_tuner.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+const char* const WorkgroupTuner::DEFAULT_TABLE = "workgroup_sizes.txt";
+
+// the table is keyed on the file name, so a build directory and the source
+// tree share their entries
+static std::string kernelName(const char* computePath) {
+    return std::filesystem::path(computePath).filename().string();
+}
+
+WorkgroupTuner::WorkgroupTuner(ComputeBackend backend, const std::string& table)
+    : backend(backend), table(table) {
+}
+
+std::string WorkgroupTuner::deviceName() const {
+    if (backend == ComputeBackend::CPU)
+        return "CPU (" + std::to_string(ThreadPool::global().size()) + " threads)";
+    const GLubyte* vendor = glGetString(GL_VENDOR);
+    const GLubyte* renderer = glGetString(GL_RENDERER);
+    return std::string(vendor ? (const char*)vendor : "") + " " + (renderer ? (const char*)renderer : "");
+}
+
+std::vector<glm::uvec3> WorkgroupTuner::defaultCandidates() const {
+    static const glm::uvec3 sizes[] = {
+        { 8, 8, 1 }, { 16, 8, 1 }, { 8, 16, 1 }, { 16, 16, 1 }, { 10, 10, 1 },
+        { 32, 8, 1 }, { 8, 32, 1 }, { 32, 16, 1 }, { 16, 32, 1 }, { 32, 32, 1 },
+        { 64, 1, 1 }, { 64, 4, 1 }, { 128, 1, 1 }, { 256, 1, 1 },
+    };
+    GLint maxInvocations = 1024, maxX = 1024, maxY = 1024;
+    if (backend == ComputeBackend::GL) {
+        glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &maxInvocations);
+        glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 0, &maxX);
+        glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 1, &maxY);
+    }
+    std::vector<glm::uvec3> result;
+    for (const glm::uvec3& size : sizes) {
+        if (size.x * size.y <= (GLuint)maxInvocations && size.x <= (GLuint)maxX && size.y <= (GLuint)maxY)
+            result.push_back(size);
+    }
+    return result;
+}
+
+double WorkgroupTuner::time(ComputeShader& shader, unsigned width, unsigned height) const {
+    shader.use();
+    if (backend == ComputeBackend::CPU) {
+        shader.dispatchFor(width, height);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++)
+            shader.dispatchFor(width, height);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+    }
+
+    for (int i = 0; i < WARMUP_DISPATCHES; i++)
+        shader.dispatchFor(width, height);
+    glFinish();
+
+    // timestamps rather than GL_TIME_ELAPSED, as GpuProfiler does; offline,
+    // so waiting for the result is fine
+    GLuint queries[2];
+    glGenQueries(2, queries);
+    auto start = std::chrono::steady_clock::now();
+    glQueryCounter(queries[0], GL_TIMESTAMP);
+    for (int i = 0; i < repeats; i++)
+        shader.dispatchFor(width, height);
+    glQueryCounter(queries[1], GL_TIMESTAMP);
+    glFinish();
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &end);
+    glDeleteQueries(2, queries);
+    // a clock that saw under 1% of the wall time is stamping at submission
+    // (llvmpipe does), not when the dispatches ran
+    double gpuMs = end > begin ? (end - begin) / 1.0e6 : 0.0;
+    if (gpuMs < wallMs * 0.01)
+        return wallMs / repeats;
+    return gpuMs / repeats;
+}
+
+WorkgroupSize WorkgroupTuner::tune(const char* computePath, unsigned width, unsigned height,
+                                   const std::function<void(ComputeShader&)>& setup) {
+    std::vector<glm::uvec3> sizes = candidates.empty() ? defaultCandidates() : candidates;
+    lastResults.clear();
+
+    // submit every variant before waiting for the first one
+    std::vector<ProgramFuture> programs;
+    if (backend == ComputeBackend::GL) {
+        for (const glm::uvec3& size : sizes)
+            programs.push_back(ProgramBuilder::compute(computePath, WorkgroupSize(size).defines() + defines));
+    }
+
+    WorkgroupSize best;
+    double bestMs = 0.0;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        ComputeShader shader = backend == ComputeBackend::GL
+            ? ComputeShader(programs[i])
+            : ComputeShader(computePath, WorkgroupSize(sizes[i]), ComputeBackend::CPU);
+        if (backend == ComputeBackend::GL && shader.ID == 0)
+            continue;
+        setup(shader);
+        double ms = time(shader, width, height);
+        lastResults.push_back({ sizes[i], ms });
+        if (best.isDefault() || ms < bestMs) {
+            best = WorkgroupSize(sizes[i]);
+            bestMs = ms;
+        }
+        if (shader.ID)
+            glDeleteProgram(shader.ID);
+    }
+    if (!best.isDefault())
+        save(kernelName(computePath), best.local);
+    return best;
+}
+
+// Table lines: kernel <TAB> device <TAB> x y z
+WorkgroupSize WorkgroupTuner::saved(const char* computePath) const {
+    std::ifstream file(table);
+    std::string kernel = kernelName(computePath);
+    std::string device = deviceName();
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string lineKernel, lineDevice, size;
+        if (!std::getline(fields, lineKernel, '\t') || !std::getline(fields, lineDevice, '\t') || !std::getline(fields, size))
+            continue;
+        if (lineKernel != kernel || lineDevice != device)
+            continue;
+        glm::uvec3 local(0);
+        std::istringstream(size) >> local.x >> local.y >> local.z;
+        if (local.x && local.y && local.z)
+            return WorkgroupSize(local);
+    }
+    return WorkgroupSize();
+}
+
+void WorkgroupTuner::save(const std::string& kernel, const glm::uvec3& local) const {
+    std::string device = deviceName();
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(table);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line.compare(0, kernel.size() + device.size() + 2, kernel + "\t" + device + "\t") == 0)
+                continue;
+            lines.push_back(line);
+        }
+    }
+    lines.push_back(kernel + "\t" + device + "\t" + std::to_string(local.x) + " " + std::to_string(local.y) + " "
+                    + std::to_string(local.z));
+
+    // write a new table and rename it over the old one, as ProgramCache does
+    std::string temporary = table + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        for (const std::string& line : lines)
+            file << line << "\n";
+        if (!file)
+            return;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, table, error);
+    if (error)
+        std::filesystem::remove(temporary, error);
+}
@@ -1,6 +1,11 @@
 #include <iostream>
 #include <SDL3/SDL.h>
 #include <glad/glad.h>
+#include <cstdlib>
+#include <cstring>
+#include "app_context.h"
+#include "presenter.h"
+#include "output_image.h"
 
 // Configuración de la ventana y la textura
 const int SCR_WIDTH = 800;
@@ -8,44 +13,16 @@ const int SCR_HEIGHT = 600;
 const int TEXTURE_WIDTH = 800; // Resolución de la textura
 const int TEXTURE_HEIGHT = 600;
 const int RANGE = 10;
+// cada cuántos frames se muestra la espera del readback
+const int STALL_REPORT_FRAMES = 120;
 
 int main(int argv, char** args) {
-    // Inicializa SDL
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
-        return -1;
-    }
-
-    // Configura atributos de OpenGL
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-
-    // Crea una ventana de SDL
-    SDL_Window* window = SDL_CreateWindow("Mouse Pixel Highlighter", 
-                                          SCR_WIDTH, SCR_HEIGHT, 
-                                          SDL_WINDOW_OPENGL );
-    if (!window) {
-        std::cerr << "Failed to create SDL window: " << SDL_GetError() << std::endl;
-        SDL_Quit();
-        return -1;
-    }
+    // --headless [--frames N] [--output frame.ppm] [--present blit|quad|readback]: sin ventana, contexto EGL
+    RunOptions options = RunOptions::parse(argv, args);
 
-    // Crea un contexto OpenGL
-    SDL_GLContext glContext = SDL_GL_CreateContext(window);
-    if (!glContext) {
-        std::cerr << "Failed to create OpenGL context: " << SDL_GetError() << std::endl;
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        return -1;
-    }
-
-    // Inicializa GLAD
-    if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        SDL_GL_DestroyContext(glContext);
-        SDL_DestroyWindow(window);
-        SDL_Quit();
+    // Crea la ventana de SDL y el contexto OpenGL 4.3, inicializa GLAD
+    AppContext app;
+    if (!app.create("Mouse Pixel Highlighter", SCR_WIDTH, SCR_HEIGHT, options)) {
         return -1;
     }
 
@@ -88,37 +65,29 @@ int main(int argv, char** args) {
     glLinkProgram(computeProgram);
     glDeleteShader(computeShader);
 
-    // Crea la textura en OpenGL
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, TEXTURE_WIDTH, TEXTURE_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA8);
-
-    // Configura un PBO para transferencias optimizadas
-    GLuint pbo;
-    glGenBuffers(1, &pbo);
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-    glBufferData(GL_PIXEL_PACK_BUFFER, TEXTURE_WIDTH * TEXTURE_HEIGHT * 4 * sizeof(uint8_t), nullptr, GL_STREAM_READ);
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-
-    GLuint framebuffer;
-    glGenFramebuffers(1, &framebuffer);
-
-    // Configura SDL para renderizar
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, nullptr);
-    SDL_Texture* sdlTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, 
-                                                 SDL_TEXTUREACCESS_STREAMING, 
-                                                 TEXTURE_WIDTH, TEXTURE_HEIGHT);
-
-    // Variables para las dimensiones de la ventana y escalado
-    int windowWidth, windowHeight;
-    SDL_GetWindowSize(window, &windowWidth, &windowHeight); // Obtén el tamaño de la ventana
+    // Crea la imagen de salida (rgba8, como la declara el shader)
+    OutputImage image;
+    image.create(TEXTURE_WIDTH, TEXTURE_HEIGHT, ImageFormat::RGBA8);
+    image.bindImage(0, GL_READ_WRITE);
+
+    // Presentación: blit por defecto (sin pasar por la CPU); --present quad o
+    // --present readback para comparar. En readback el anillo de PBOs muestra el
+    // frame leído (profundidad - 1) frames antes: ./test2 [profundidad] [persistent]
+    // "persistent" mapea los PBOs una sola vez (ARB_buffer_storage)
+    PresentMode presentMode = PresentMode::Blit;
+    if (!options.present.empty() && !Presenter::parseMode(options.present.c_str(), presentMode))
+        std::cerr << "Modo de presentación desconocido: " << options.present << std::endl;
+    int pboDepth = argv > 1 ? std::atoi(args[1]) : PboReadback::DEFAULT_DEPTH;
+    ReadbackMode pboMode = argv > 2 && std::strcmp(args[2], "persistent") == 0
+        ? ReadbackMode::Persistent : ReadbackMode::MapPerFrame;
+    Presenter presenter;
+    if (!presenter.create(app, presentMode, pboDepth, pboMode))
+        return -1;
+    std::cout << "Presentación: " << Presenter::modeName(presenter.mode()) << std::endl;
+
+    // Escala del mouse (ventana) a la textura
+    int windowWidth = SCR_WIDTH, windowHeight = SCR_HEIGHT;
+    app.getDrawableSize(windowWidth, windowHeight);
     float scaleX = (float)TEXTURE_WIDTH / (float)windowWidth;
     float scaleY = (float)TEXTURE_HEIGHT / (float)windowHeight;
 
@@ -130,8 +99,9 @@ int main(int argv, char** args) {
 
     // Bucle de renderizado
     bool running = true;
+    int frameCount = 0;
     SDL_Event event;
-    while (running) {
+    while (running && app.nextFrame()) {
         static uint64_t frequency = SDL_GetPerformanceFrequency();
 		uint64_t currentFrame = SDL_GetPerformanceCounter();
 		deltaTime = static_cast<double>(currentFrame - lastFrame) / frequency;
@@ -145,57 +115,33 @@ int main(int argv, char** args) {
         }
         SDL_GetMouseState(&mouseX, &mouseY);
         int textureMouseX = (int)(mouseX * scaleX);
-        int textureMouseY = (int)(mouseY * scaleY);
-
-
-        // Invierte las coordenadas Y (de SDL a OpenGL)
-        // mouseY = TEXTURE_HEIGHT - mouseY;
+        // Invierte las coordenadas Y (de SDL a OpenGL): la fila 0 de la textura es la de abajo
+        int textureMouseY = TEXTURE_HEIGHT - 1 - (int)(mouseY * scaleY);
 
         // Ejecuta el compute shader
         glUseProgram(computeProgram);
         glUniform2i(glGetUniformLocation(computeProgram, "mousePos"), textureMouseX, textureMouseY);
         glUniform1i(glGetUniformLocation(computeProgram, "range"), RANGE);
         glDispatchCompute(TEXTURE_WIDTH / 16, TEXTURE_HEIGHT / 16, 1);
-        glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+        glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        // Muestra la imagen (y cambia el buffer)
+        presenter.present(image.texture(), TEXTURE_WIDTH, TEXTURE_HEIGHT);
 
-        // Inicia la transferencia asincrónica con PBO
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-        glReadPixels(0, 0, TEXTURE_WIDTH, TEXTURE_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-
-        // Mapea los datos del PBO para pasarlos a SDL
-        Uint8* pixels = (Uint8*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
-        if (pixels) {
-            SDL_UpdateTexture(sdlTexture, nullptr, pixels, TEXTURE_WIDTH * 4);
-            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-        }
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-
-        // Leer datos de la textura y actualizarlos en SDL
-        // glBindTexture(GL_TEXTURE_2D, texture);
-        // Uint8* pixels = new Uint8[TEXTURE_WIDTH * TEXTURE_HEIGHT * 4];
-        // glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-
-        // SDL_UpdateTexture(sdlTexture, nullptr, pixels, TEXTURE_WIDTH * 4);
-        // delete[] pixels;
-
-        // Renderiza la textura en SDL
-        SDL_RenderClear(renderer);
-        SDL_RenderTexture(renderer, sdlTexture, nullptr, nullptr);
-        SDL_RenderPresent(renderer);
+        const PboReadback* readback = presenter.readback();
+        if (readback && ++frameCount % STALL_REPORT_FRAMES == 0)
+            std::cout << "PBO x" << readback->getDepth() << (readback->isPersistent() ? " persistente" : "") << ": espera " << readback->lastStallMs()
+                      << " ms (media " << readback->averageStallMs() << " ms)" << std::endl;
     }
 
+    if (!options.output.empty() && !saveTexturePPM(options.output, image.texture(), TEXTURE_WIDTH, TEXTURE_HEIGHT))
+        std::cerr << "No se pudo escribir " << options.output << std::endl;
+
     // Limpieza
-    SDL_DestroyTexture(sdlTexture);
-    SDL_DestroyRenderer(renderer);
-    glDeleteTextures(1, &texture);
+    presenter.release();
+    image.release();
     glDeleteProgram(computeProgram);
-    glDeleteBuffers(1, &pbo);
-    SDL_GL_DestroyContext(glContext);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    app.destroy();
 
     return 0;
 }
\ No newline at end of file
@@ -3,61 +3,73 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <cstring> 
+#include <cstdlib>
 #include "shader_c.h"
+#include "workgroup_tuner.h"
+#include "presenter.h"
+#include "app_context.h"
+#include "gpu_profiler.h"
+#include "output_image.h"
 
 // Configuración de la ventana y la textura
 const int SCR_WIDTH = 800;
 const int SCR_HEIGHT = 600;
 const int TEXTURE_WIDTH = 800; // Resolución de la textura
 const int TEXTURE_HEIGHT = 600;
+// la luz se lee de vuelta como RGBA8, más bits no llegan a la pantalla
+const ImageFormat IMAGE_FORMAT = ImageFormat::RGBA8;
 const int RANGE = 10;
+// cada cuántos frames se muestra la espera del readback y el tiempo de GPU
+const int STALL_REPORT_FRAMES = 120;
 
 double deltaTime = 0.0; // time between current frame and last frame
 double lastFrame = 0.0;
 
-void setTexture(GLuint& texId);
-
 int main(int argv, char** args) {
-    // Inicializar SDL
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
-        return -1;
-    }
+    // --headless [--frames N] [--output frame.ppm]: sin ventana, contexto EGL
+    RunOptions options = RunOptions::parse(argv, args);
 
     // Crear ventana y contexto OpenGL
-    SDL_Window* window = SDL_CreateWindow("Compute Shader + SDL Renderer",
-                                          SCR_WIDTH, SCR_HEIGHT, SDL_WINDOW_OPENGL);
-    SDL_GLContext glContext = SDL_GL_CreateContext(window);
-    gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress);
+    AppContext app;
+    if (!app.create("Compute Shader + SDL Renderer", SCR_WIDTH, SCR_HEIGHT, options))
+        return -1;
 
 
-    ComputeShader computeShader("computeShader2.cs");
+    // local_size elegido por tune_workgroups para este dispositivo, si lo hay
+    WorkgroupSize workgroupSize = WorkgroupTuner::saved("computeShader2.cs", ComputeBackend::GL);
+    ComputeShader computeShader(ProgramBuilder::compute("computeShader2.cs", workgroupSize.defines() + imageFormatDefines(IMAGE_FORMAT)));
     computeShader.use();
 
-    // Crear textura OpenGL para el Compute Shader
-    GLuint texture;
-    setTexture(texture);
-
-    // Configurar un PBO para transferencias optimizadas
-    GLuint pbo;
-    glGenBuffers(1, &pbo);
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-    glBufferData(GL_PIXEL_PACK_BUFFER, SCR_WIDTH * SCR_HEIGHT * 4 * sizeof(uint8_t), nullptr, GL_STREAM_READ);
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-
-    GLuint framebuffer;
-    glGenFramebuffers(1, &framebuffer);
+    // Imagen de salida del Compute Shader (glTexStorage2D, tamaño y formato fijos)
+    OutputImage image;
+    image.create(TEXTURE_WIDTH, TEXTURE_HEIGHT, IMAGE_FORMAT);
+    image.bindImage(0);
+
+    // Presentación: blit por defecto (sin pasar por la CPU); --present quad o
+    // --present readback para comparar. En readback el anillo de PBOs muestra el
+    // frame leído (profundidad - 1) frames antes: ./test3 [profundidad] [persistent]
+    // "persistent" mapea los PBOs una sola vez (ARB_buffer_storage)
+    PresentMode presentMode = PresentMode::Blit;
+    if (!options.present.empty() && !Presenter::parseMode(options.present.c_str(), presentMode))
+        std::cerr << "Modo de presentación desconocido: " << options.present << std::endl;
+    int pboDepth = argv > 1 ? std::atoi(args[1]) : PboReadback::DEFAULT_DEPTH;
+    ReadbackMode pboMode = argv > 2 && std::strcmp(args[2], "persistent") == 0
+        ? ReadbackMode::Persistent : ReadbackMode::MapPerFrame;
+    Presenter presenter;
+    if (!presenter.create(app, presentMode, pboDepth, pboMode))
+        return -1;
+    std::cout << "Presentación: " << Presenter::modeName(presenter.mode()) << std::endl;
 
-    // Configurar textura SDL
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, nullptr);
-    SDL_Texture* sdlTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING,
-                                                 SCR_WIDTH, SCR_HEIGHT);
+    // Tiempo de GPU por etapa, leído dos frames después para no bloquear
+    GpuProfiler profiler;
+    profiler.create();
 
     bool running = true;
     SDL_Event event;
     float mouseX = 0.0f, mouseY = 0.0f;
+    int frameCount = 0;
 
-    while (running) {
+    while (running && app.nextFrame()) {
 
         static uint64_t frequency = SDL_GetPerformanceFrequency();
 		uint64_t currentFrame = SDL_GetPerformanceCounter();
@@ -74,60 +86,49 @@ int main(int argv, char** args) {
         int textureMouseX = (int)mouseX;
         int textureMouseY = SCR_HEIGHT - (int)mouseY;
 
-        int lightX = mouseX; // Mueve la luz con el mouse
-        int lightY = mouseY;
+        int lightX = textureMouseX; // Mueve la luz con el mouse
+        int lightY = textureMouseY;
         float lightIntensity = 5.0f; // Ajusta la intensidad
 
         // Ejecutar el Compute Shader
-        computeShader.setInt("SCR_WIDTH", SCR_WIDTH);
-        computeShader.setInt("SCR_HEIGHT", SCR_HEIGHT);
-        computeShader.setVec2I("lightPos", glm::vec2(lightX, lightY));
-        computeShader.setFloat("lightIntensity", lightIntensity);
-        computeShader.setVec4("baseColor", glm::vec4(0.2f, 0.5f, 0.8f, 1.0f));
-    
-        glDispatchCompute((SCR_WIDTH + 15) / 16, (SCR_HEIGHT + 15) / 16, 1);
-        glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-
-        // Transferir datos con PBO
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-        glReadPixels(0, 0, SCR_WIDTH, SCR_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-
-        // Mapear el PBO para pasarlo a SDL
-        Uint8* pixels = (Uint8*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
-        if (pixels) {
-            SDL_UpdateTexture(sdlTexture, nullptr, pixels, SCR_WIDTH * 4);
-            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        profiler.beginFrame();
+        {
+            GpuScope scope(profiler, "dispatch");
+            computeShader.setInt("SCR_WIDTH", SCR_WIDTH);
+            computeShader.setInt("SCR_HEIGHT", SCR_HEIGHT);
+            computeShader.setVec2I("lightPos", glm::vec2(lightX, lightY));
+            computeShader.setFloat("lightIntensity", lightIntensity);
+            computeShader.setVec4("baseColor", glm::vec4(0.2f, 0.5f, 0.8f, 1.0f));
+        
+            computeShader.dispatchFor(SCR_WIDTH, SCR_HEIGHT);
+            glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
         }
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-        // Renderizar la textura con SDL
-        SDL_RenderClear(renderer);
-        SDL_RenderTexture(renderer, sdlTexture, nullptr, nullptr);
-        SDL_RenderPresent(renderer);
+        // Mostrar la imagen (y cambiar el buffer)
+        {
+            GpuScope scope(profiler, Presenter::modeName(presenter.mode()));
+            presenter.present(image.texture(), SCR_WIDTH, SCR_HEIGHT);
+        }
+        profiler.endFrame();
+
+        if (++frameCount % STALL_REPORT_FRAMES == 0) {
+            const PboReadback* readback = presenter.readback();
+            if (readback)
+                std::cout << "PBO x" << readback->getDepth() << (readback->isPersistent() ? " persistente" : "") << ": espera " << readback->lastStallMs()
+                          << " ms (media " << readback->averageStallMs() << " ms)" << std::endl;
+            profiler.print(std::cout);
+        }
     }
 
+    if (!options.output.empty() && !saveTexturePPM(options.output, image.texture(), SCR_WIDTH, SCR_HEIGHT))
+        std::cerr << "No se pudo escribir " << options.output << std::endl;
+
     // Limpieza
-    glDeleteBuffers(1, &pbo);
-    glDeleteTextures(1, &texture);
+    profiler.release();
+    presenter.release();
+    image.release();
     // glDeleteProgram(computeProgram);
-    SDL_DestroyTexture(sdlTexture);
-    SDL_DestroyRenderer(renderer);
-    SDL_GL_DestroyContext(glContext);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    app.destroy();
 
     return 0;
 }
-
-void setTexture(GLuint& texId) {
-    glGenTextures(1, &texId);
-    glBindTexture(GL_TEXTURE_2D, texId);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, TEXTURE_WIDTH, TEXTURE_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glBindImageTexture(0, texId, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
-}
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include <iostream>
+#include <vector>
 #include <SDL3/SDL.h>
 #include <glad/glad.h>
+#include "app_context.h"
+#include "output_image.h"
 
 // Configuración
 const int SCR_WIDTH = 800;
@@ -11,15 +14,12 @@ double deltaTime = 0.0; // time between current frame and last frame
 double lastFrame = 0.0;
 
 int main(int argv, char** args) {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "Error al inicializar SDL: " << SDL_GetError() << std::endl;
-        return -1;
-    }
+    // --headless [--frames N] [--output frame.ppm]: sin ventana, contexto EGL
+    RunOptions options = RunOptions::parse(argv, args);
 
-    SDL_Window* window = SDL_CreateWindow("Compute Shader + SDL3 Renderer",
-                                          SCR_WIDTH, SCR_HEIGHT, SDL_WINDOW_OPENGL);
-    SDL_GLContext glContext = SDL_GL_CreateContext(window);
-    gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress);
+    AppContext app;
+    if (!app.create("Compute Shader + SDL3 Renderer", SCR_WIDTH, SCR_HEIGHT, options))
+        return -1;
 
     // Crear Compute Shader
     const char* computeShaderSource = R"(
@@ -56,17 +56,23 @@ int main(int argv, char** args) {
     glLinkProgram(computeProgram);
     glDeleteShader(computeShader);
 
-    // Crear textura para el Compute Shader
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
-
-    // Configurar SDL Texture
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, nullptr);
-    SDL_Texture* sdlTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
-                                                 SDL_TEXTUREACCESS_STREAMING, SCR_WIDTH, SCR_HEIGHT);
+    // Crear la imagen de salida del Compute Shader
+    OutputImage image;
+    image.create(SCR_WIDTH, SCR_HEIGHT, ImageFormat::RGBA8);
+    image.bindImage(0);
+
+    // Configurar SDL Texture (sin ventana se descarga a memoria)
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* sdlTexture = nullptr;
+    std::vector<Uint8> headlessPixels;
+    if (app.isHeadless()) {
+        headlessPixels.resize(SCR_WIDTH * SCR_HEIGHT * 4);
+    }
+    else {
+        renderer = SDL_CreateRenderer(app.getWindow(), nullptr);
+        sdlTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                       SDL_TEXTUREACCESS_STREAMING, SCR_WIDTH, SCR_HEIGHT);
+    }
 
     bool running = true;
     SDL_Event event;
@@ -74,30 +80,39 @@ int main(int argv, char** args) {
     int lightX = SCR_WIDTH / 2, lightY = SCR_HEIGHT / 2;
     int lightRadius = 200;
 
-    while (running) {
+    while (running && app.nextFrame()) {
 
         static uint64_t frequency = SDL_GetPerformanceFrequency();
 		uint64_t currentFrame = SDL_GetPerformanceCounter();
 		deltaTime = static_cast<double>(currentFrame - lastFrame) / frequency;
 		lastFrame = currentFrame;
 
+        // Sin ventana no hay eventos de mouse: se ejecuta en cada frame
+        bool moved = app.isHeadless();
         while (SDL_PollEvent(&event)) {
             std::cout << "FPS: " << 1 / deltaTime << std::endl;
             if (event.type == SDL_EVENT_QUIT) running = false;
             if (event.type == SDL_EVENT_MOUSE_MOTION) {
                 lightX = event.motion.x;
                 lightY = event.motion.y;
-
-                // Ejecutar Compute Shader
-                glUseProgram(computeProgram);
-                glUniform2i(glGetUniformLocation(computeProgram, "lightPos"), lightX, lightY);
-                glUniform1i(glGetUniformLocation(computeProgram, "lightRadius"), lightRadius);
-                glDispatchCompute((SCR_WIDTH + 15) / 16, (SCR_HEIGHT + 15) / 16, 1);
-                glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
-                // Descargar la textura en SDL
-                glBindTexture(GL_TEXTURE_2D, texture);
+                moved = true;
             }
         }
+        if (moved) {
+            // Ejecutar Compute Shader
+            glUseProgram(computeProgram);
+            glUniform2i(glGetUniformLocation(computeProgram, "lightPos"), lightX, lightY);
+            glUniform1i(glGetUniformLocation(computeProgram, "lightRadius"), lightRadius);
+            glDispatchCompute((SCR_WIDTH + 15) / 16, (SCR_HEIGHT + 15) / 16, 1);
+            glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+            // Descargar la textura en SDL
+            glBindTexture(GL_TEXTURE_2D, image.texture());
+        }
+
+        if (app.isHeadless()) {
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, headlessPixels.data());
+            continue;
+        }
 
         void* pixels;
         int pitch;
@@ -112,14 +127,17 @@ int main(int argv, char** args) {
         SDL_RenderPresent(renderer);
     }
 
+    if (app.isHeadless() && !options.output.empty() && !writeRGBA8PPM(options.output, headlessPixels.data(), SCR_WIDTH, SCR_HEIGHT, true))
+        std::cerr << "No se pudo escribir " << options.output << std::endl;
+
     // Limpieza
-    SDL_DestroyTexture(sdlTexture);
-    SDL_DestroyRenderer(renderer);
-    glDeleteTextures(1, &texture);
+    if (renderer) {
+        SDL_DestroyTexture(sdlTexture);
+        SDL_DestroyRenderer(renderer);
+    }
+    image.release();
     glDeleteProgram(computeProgram);
-    SDL_GL_DestroyContext(glContext);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    app.destroy();
 
     return 0;
 }
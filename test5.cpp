@@ -1,6 +1,8 @@
 #include <iostream>
 #include <SDL3/SDL.h>
 #include <glad/glad.h>
+#include "app_context.h"
+#include "output_image.h"
 
 // Configuración
 const int SCR_WIDTH = 800;
@@ -11,15 +13,12 @@ double deltaTime = 0.0; // time between current frame and last frame
 double lastFrame = 0.0;
 
 int main(int argv, char** args) {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "Error al inicializar SDL: " << SDL_GetError() << std::endl;
-        return -1;
-    }
+    // --headless [--frames N] [--output frame.ppm]: sin ventana, contexto EGL
+    RunOptions options = RunOptions::parse(argv, args);
 
-    SDL_Window* window = SDL_CreateWindow("Compute Shader + SDL3 Renderer",
-                                          SCR_WIDTH, SCR_HEIGHT, SDL_WINDOW_OPENGL);
-    SDL_GLContext glContext = SDL_GL_CreateContext(window);
-    gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress);
+    AppContext app;
+    if (!app.create("Compute Shader + SDL3 Renderer", SCR_WIDTH, SCR_HEIGHT, options))
+        return -1;
 
     // Crear Compute Shader
     const char* computeShaderSource = R"(
@@ -56,20 +55,16 @@ int main(int argv, char** args) {
     glLinkProgram(computeProgram);
     glDeleteShader(computeShader);
 
-    // Crear textura para el Compute Shader
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    // Crear la imagen de salida del Compute Shader
+    OutputImage image;
+    image.create(SCR_WIDTH, SCR_HEIGHT, ImageFormat::RGBA8);
+    image.bindImage(0);
 
     // Crear un framebuffer para renderizar
     GLuint fbo;
     glGenFramebuffers(1, &fbo);
     glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
-    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, image.texture(), 0);
 
     // Configurar SDL Texture
     // SDL_Renderer* renderer = SDL_CreateRenderer(window, nullptr);
@@ -82,7 +77,7 @@ int main(int argv, char** args) {
     int lightX = SCR_WIDTH / 2, lightY = SCR_HEIGHT / 2;
     int lightRadius = 200;
 
-    while (running) {
+    while (running && app.nextFrame()) {
 
         static uint64_t frequency = SDL_GetPerformanceFrequency();
 		uint64_t currentFrame = SDL_GetPerformanceCounter();
@@ -111,7 +106,7 @@ int main(int argv, char** args) {
         glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 
         // Actualizar pantalla
-        SDL_GL_SwapWindow(window);
+        app.swap();
 
         // void* pixels;
         // int pitch;
@@ -126,15 +121,16 @@ int main(int argv, char** args) {
         // SDL_RenderPresent(renderer);
     }
 
+    if (!options.output.empty() && !saveTexturePPM(options.output, image.texture(), SCR_WIDTH, SCR_HEIGHT))
+        std::cerr << "No se pudo escribir " << options.output << std::endl;
+
     // Limpieza
     // SDL_DestroyTexture(sdlTexture);
     // SDL_DestroyRenderer(renderer);
     glDeleteFramebuffers(1, &fbo);
-    glDeleteTextures(1, &texture);
+    image.release();
     glDeleteProgram(computeProgram);
-    SDL_GL_DestroyContext(glContext);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    app.destroy();
 
     return 0;
 }
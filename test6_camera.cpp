@@ -4,65 +4,116 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "camera3.h"
 #include "shader_c.h"
+#include "sphere_scene.h"
+#include "bvh.h"
+#include "frame_params.h"
+#include "uniform_ring.h"
 #include <SDL3/SDL.h>
+#include <cstdlib>
+#include <cstring>
 #include <glad/glad.h>
+#include "app_context.h"
+#include "gpu_profiler.h"
+#include "shader_watcher.h"
+#include "workgroup_tuner.h"
+#include "render_target_pool.h"
+#include "output_image.h"
+#include "pixel_order.h"
+#include "progressive.h"
 
 // Configuración
 const int SCR_WIDTH = 800;
 const int SCR_HEIGHT = 600;
 
+// el shader aplica la gamma antes de escribir: 8 bits por canal bastan
+const ImageFormat IMAGE_FORMAT = ImageFormat::RGBA8;
+
+// cada cuántos frames se muestra el tiempo de GPU por etapa
+const int PROFILE_REPORT_FRAMES = 120;
+
 double deltaTime = 0.0; // time between current frame and last frame
 double lastFrame = 0.0;
 
 Camera* global_cam;
 
-// Datos de la esfera
-struct Sphere {
-    glm::vec3 position;
-    float radius;
-};
-
-Sphere sphere = {glm::vec3(0.0f, 5.0f, 0.0f), 2.0f};
-
 int main(int argv, char** args) {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "Error al inicializar SDL: " << SDL_GetError() << std::endl;
-        return -1;
-    }
-
-    SDL_Window* window = SDL_CreateWindow("Compute Shader + SDL3 Renderer",
-                                          SCR_WIDTH, SCR_HEIGHT, SDL_WINDOW_OPENGL);
-    SDL_GLContext glContext = SDL_GL_CreateContext(window);
-    gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress);
+    // --headless [--frames N] [--output frame.ppm]: sin ventana, contexto EGL
+    RunOptions options = RunOptions::parse(argv, args);
 
+    AppContext app;
+    if (!app.create("Compute Shader + SDL3 Renderer", SCR_WIDTH, SCR_HEIGHT, options))
+        return -1;
 
     // Obtener el tiempo inicial
     uint64_t startTime = SDL_GetPerformanceCounter();
     uint64_t frequency = SDL_GetPerformanceFrequency();
 
+    // El driver compila el shader (grande) mientras se crean la escena, la BVH y la textura
+    // con el local_size elegido por tune_workgroups para este dispositivo, si lo hay
+    WorkgroupSize workgroupSize = WorkgroupTuner::saved("computeSh_test6.cs", ComputeBackend::GL);
+    ProgramFuture computeProgram = ProgramBuilder::compute("computeSh_test6.cs", workgroupSize.defines() + imageFormatDefines(IMAGE_FORMAT));
+
     Camera camera(SCR_WIDTH, SCR_HEIGHT);
 
     global_cam = &camera;
 
     camera.SetPosition(3.0f, 0.0f, 0.0f);
 
-    ComputeShader computeShader("computeSh_test6.cs");
-    computeShader.use();
+    // Parámetros del frame en un UBO std140: una sola escritura por dispatch
+    UniformRing frameParamsRing;
+    frameParamsRing.create(FrameParams::BINDING, sizeof(FrameParams));
+    std::cout << "FrameParams UBO " << (frameParamsRing.isPersistent() ? "persistente" : "con glBufferSubData") << std::endl;
 
-    // Crear textura para el Compute Shader
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    // Escena por defecto (3 esferas) o N esferas aleatorias: ./test6 N
+    SphereScene scene = argv > 1 ? SphereScene::random(std::atoi(args[1])) : SphereScene::defaultScene();
+    // La BVH reordena las esferas, así que se construye antes de subir la escena
+    SphereBVH bvh;
+    bvh.build(scene);
+    scene.upload();
+    bvh.upload();
+
+    // Textura de salida del pool: sigue el tamaño de la ventana y solo se
+    // reasigna cuando la imagen deja de caber (o sobra mucho espacio)
+    app.setResizable(true);
+    int width = SCR_WIDTH, height = SCR_HEIGHT;
+    app.getDrawableSize(width, height);
+    camera.SetScrSize(width, height);
+    RenderTargetPool targetPool;
+    RenderTarget target;
+    target.create(targetPool, imageFormatInfo(IMAGE_FORMAT).internalFormat, width, height);
 
     // Crear un framebuffer para renderizar
     GLuint fbo;
     glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
-    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    auto bindTarget = [&]() {
+        glBindImageTexture(0, target.texture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, target.format());
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture(), 0);
+    };
+    bindTarget();
+
+    // Acumulación del modo progresivo en RGBA32F, del mismo pool; se crea la
+    // primera vez que se activa y sigue a la ventana como la salida
+    RenderTarget accumTarget;
+    auto bindAccum = [&]() {
+        glBindImageTexture(1, accumTarget.texture(), 0, GL_FALSE, 0, GL_READ_WRITE, accumTarget.format());
+    };
+
+    // Solo espera si la compilación todavía no terminó
+    std::cout << "computeSh_test6.cs " << (computeProgram.ready() ? "listo" : "compilando") << " al terminar la preparación" << std::endl;
+    ComputeShader computeShader(computeProgram);
+    computeShader.use();
+    std::cout << "Preparación: " << (SDL_GetPerformanceCounter() - startTime) * 1000.0 / frequency << " ms" << std::endl;
+
+    // Tiempo de GPU por etapa, leído dos frames después para no bloquear
+    GpuProfiler profiler;
+    profiler.create();
+
+    // Recarga en caliente: al guardar computeSh_test6.cs (el del código fuente) se
+    // recompila en segundo plano y se cambia el programa entre frames si enlaza
+    ShaderWatcher watcher;
+    if (watcher.create({ ShaderWatcher::sourcePath("computeSh_test6.cs") }))
+        std::cout << "Vigilando computeSh_test6.cs para recargarlo" << std::endl;
 
     bool running = true;
     SDL_Event event;
@@ -73,7 +124,21 @@ int main(int argv, char** args) {
 
     bool show_grid = true;
     bool show_axes = true;
-    while (running) {
+    // T: cada tile junta sus esferas en memoria compartida en vez de usar la BVH
+    // M: workgroups y píxeles en orden Morton en vez de por filas
+    // P: con la cámara quieta cada frame suma una muestra desplazada dentro del
+    // píxel y se muestra la media (antialiasing); moverla vuelve a empezar
+    // (./test6 N tiles morton progressive para empezar así)
+    bool tile_culling = false;
+    PixelOrder pixel_order = PixelOrder::RowMajor;
+    bool progressive = false;
+    for (int i = 2; i < argv; i++) {
+        if (std::strcmp(args[i], "tiles") == 0) tile_culling = true;
+        if (std::strcmp(args[i], "morton") == 0) pixel_order = PixelOrder::Morton;
+        if (std::strcmp(args[i], "progressive") == 0) progressive = true;
+    }
+    ProgressiveState progressiveState;
+    while (running && app.nextFrame()) {
 
         // static uint64_t frequency = SDL_GetPerformanceFrequency();
 		uint64_t currentFrame = SDL_GetPerformanceCounter();
@@ -84,8 +149,21 @@ int main(int argv, char** args) {
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_EVENT_QUIT) running = false;
             if (event.type == SDL_EVENT_KEY_DOWN) {
-                if (event.key.key == SDLK_G) show_grid = !show_grid;
-                if (event.key.key == SDLK_H) show_axes = !show_axes;
+                if (event.key.key == SDLK_G) { show_grid = !show_grid; progressiveState.reset(); }
+                if (event.key.key == SDLK_H) { show_axes = !show_axes; progressiveState.reset(); }
+                if (event.key.key == SDLK_T) {
+                    tile_culling = !tile_culling;
+                    std::cout << "Esferas por tile: " << (tile_culling ? "sí" : "no") << std::endl;
+                }
+                if (event.key.key == SDLK_M) {
+                    pixel_order = pixel_order == PixelOrder::Morton ? PixelOrder::RowMajor : PixelOrder::Morton;
+                    std::cout << "Orden de píxeles: " << pixelOrderName(pixel_order) << std::endl;
+                }
+                if (event.key.key == SDLK_P) {
+                    progressive = !progressive;
+                    progressiveState.reset();
+                    std::cout << "Progresivo: " << (progressive ? "sí" : "no") << std::endl;
+                }
             }
             if (event.type == SDL_EVENT_MOUSE_MOTION) {
                 camera.OnMouse((float) event.motion.x, (float) event.motion.y);
@@ -97,6 +175,14 @@ int main(int argv, char** args) {
             if (event.type == SDL_EVENT_MOUSE_WHEEL) {
                 camera.OnScroll(event.wheel.y);
             }
+            if (event.type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED) {
+                camera.SetScrSize(event.window.data1, event.window.data2);
+                if (target.resize(event.window.data1, event.window.data2))
+                    bindTarget();
+                if (accumTarget.texture() && accumTarget.resize(event.window.data1, event.window.data2))
+                    bindAccum();
+                progressiveState.reset();
+            }
         }
         //std::cout << camera.getYaw() << ", " << camera.getPitch() << std::endl; 
         
@@ -132,39 +218,86 @@ int main(int argv, char** args) {
         camera.OnRender(deltaTime);
         uint64_t elapsedTime = (SDL_GetPerformanceCounter() - startTime)/ 100000.0f;
         // Ejecutar Compute Shader
-        computeShader.setVec4("sphere", sphere.position.x, sphere.position.y, sphere.position.z, sphere.radius);
-        computeShader.setMat4("viewMatrix", camera.getView());
-
-        computeShader.setVec3("front", camera.getFront());
-        computeShader.setVec3("up", camera.getUp());
-        computeShader.setVec3("right", camera.getRight());
-        computeShader.setVec3("cameraPos", camera.getPosition());
-
-        computeShader.setVec2("screenResolution", SCR_WIDTH, SCR_HEIGHT);
-        computeShader.setFloat("iTime", elapsedTime);
-        computeShader.setFloat("FOV", camera.getFov());
-        computeShader.setFloat("show_grid", show_grid);
-        computeShader.setFloat("show_axis", show_axes);
-        
-        glDispatchCompute((SCR_WIDTH + 15) / 16, (SCR_HEIGHT + 15) / 16, 1);
-        glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+        FrameParams params = {};
+        params.viewMatrix = camera.getView();
+        params.front = camera.getFront();
+        params.up = camera.getUp();
+        params.right = camera.getRight();
+        params.cameraPos = camera.getPosition();
+        params.screenResolution = glm::vec2(target.width(), target.height());
+        params.iTime = elapsedTime;
+        params.FOV = camera.getFov();
+        params.sphereCount = scene.size();
+        params.showGrid = show_grid;
+        params.showAxis = show_axes;
+        frameParamsRing.write(&params);
+
+        for (const std::string& path : watcher.poll())
+            computeShader.reload(path.c_str());
+        if (computeShader.swapIfReady()) {
+            computeShader.use();
+            progressiveState.reset();
+            std::cout << "computeSh_test6.cs recargado" << std::endl;
+        }
+
+        if (progressive && !accumTarget.texture()) {
+            accumTarget.create(targetPool, GL_RGBA32F, target.width(), target.height());
+            bindAccum();
+        }
+        // -1: la imagen ya tiene todas las muestras; no se traza, pero la
+        // elipse y los ejes siguen animándose encima de la media (overlayOnly)
+        int sample = progressive ? progressiveState.nextSample(camera) : 0;
+        bool overlay_only = sample < 0;
+
+        profiler.beginFrame();
+        {
+            GpuScope scope(profiler, "dispatch");
+            computeShader.setBool("tileCulling", tile_culling);
+            computeShader.setInt("pixelOrder", (int)pixel_order);
+            computeShader.setBool("progressive", progressive);
+            computeShader.setBool("overlayOnly", overlay_only);
+            computeShader.setInt("sampleIndex", overlay_only ? progressiveState.sampleCount() - 1 : sample);
+            computeShader.setVec2("sampleJitter", ProgressiveState::jitter(overlay_only ? 0 : sample));
+            computeShader.dispatchFor(target.width(), target.height());
+            // la siguiente muestra lee la acumulación con imageLoad
+            glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        }
+        frameParamsRing.endFrame();
         
         // Blit del framebuffer al default framebuffer (pantalla)
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
-        glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        {
+            GpuScope scope(profiler, "blit");
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+            glBlitFramebuffer(0, 0, target.width(), target.height(), 0, 0, target.width(), target.height(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+        profiler.endFrame();
+        if (app.getFrame() % PROFILE_REPORT_FRAMES == 0) {
+            profiler.print(std::cout);
+            std::cout << "Salida " << target.width() << "x" << target.height() << ", texturas: "
+                      << targetPool.textureCount() << " (" << targetPool.allocations() << " asignadas)" << std::endl;
+            if (progressive)
+                std::cout << "Muestras acumuladas: " << progressiveState.sampleCount() << std::endl;
+        }
 
         // Actualizar pantalla
-        SDL_GL_SwapWindow(window);
+        app.swap();
 
     }
 
+    if (!options.output.empty() && !saveTexturePPM(options.output, target.texture(), target.width(), target.height()))
+        std::cerr << "No se pudo escribir " << options.output << std::endl;
+
     // Limpieza
+    profiler.release();
+    frameParamsRing.release();
+    bvh.release();
+    scene.release();
     glDeleteFramebuffers(1, &fbo);
-    glDeleteTextures(1, &texture);
-    SDL_GL_DestroyContext(glContext);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    accumTarget.release();
+    target.release();
+    targetPool.release();
+    app.destroy();
 
     return 0;
 }
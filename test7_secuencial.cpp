@@ -4,7 +4,15 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include "camera3.h"
+#include "tile_renderer.h"
+#include "ray_packet.h"
+#include "sphere_scene.h"
+#include "bvh.h"
+#include "app_context.h"
+#include "progressive.h"
 #include <SDL3/SDL.h>
 
 // Configuración
@@ -54,8 +62,9 @@ ProjectionResult projectSphere(const glm::vec4& sph, const glm::mat4& cam, float
             -2.0f * o.x * o.z * fle, -2.0f * o.y * o.z * fle, (r2 - l2 + z2) * fle * fle};
 }
 
-void renderImage(std::vector<Uint32>& pixels, const glm::vec4* spheres, int sphereCount, const glm::mat4& viewMatrix,
-                 const glm::vec2& resolution, bool showGrid, bool showAxis, float iTime);
+void renderImage(std::vector<Uint32>& pixels, const SphereScene& scene, const SphereBVH& bvh, const glm::mat4& viewMatrix,
+                 const glm::vec2& resolution, bool showGrid, bool showAxis, float iTime, PixelOrder order,
+                 std::vector<glm::vec4>* accum, int sample);
 
 Uint32 vec4ToUint32(const glm::vec4 color) {
     Uint8 r = static_cast<Uint8>(glm::clamp(color.r, 0.0f, 1.0f) * 255.0f);
@@ -66,25 +75,33 @@ Uint32 vec4ToUint32(const glm::vec4 color) {
 }
 
 int main(int argc, char** argv) {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "Error al inicializar SDL: " << SDL_GetError() << std::endl;
+    // --headless [--frames N] [--output frame.ppm]: sin ventana (no usa GL)
+    RunOptions options = RunOptions::parse(argc, argv);
+
+    AppContext app;
+    if (!app.create("Raytracing Secuencial", SCR_WIDTH, SCR_HEIGHT, options, false))
         return -1;
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* texture = nullptr;
+    if (!app.isHeadless()) {
+        renderer = SDL_CreateRenderer(app.getWindow(), NULL);
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, SCR_WIDTH, SCR_HEIGHT);
     }
 
-    SDL_Window* window = SDL_CreateWindow("Raytracing Secuencial", SCR_WIDTH, SCR_HEIGHT, SDL_WINDOW_OPENGL);
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, NULL);
-    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, SCR_WIDTH, SCR_HEIGHT);
-
-    // Sphere sphere = {glm::vec3(0.0f, 0.0f, -5.0f), 2.0f};
-    glm::vec4 spheres[3] = {glm::vec4(-2.0f, 1.0f, 0.0f, 1.1f), 
-                            glm::vec4(3.0f, 1.5f, 1.0f, 1.2f), 
-                            glm::vec4(1.0f, -1.0f, 1.0f, 1.3f)};
+    // Escena por defecto (3 esferas) o N esferas aleatorias: ./test7 N
+    SphereScene scene = argc > 1 ? SphereScene::random(std::atoi(argv[1])) : SphereScene::defaultScene();
+    // La BVH reordena las esferas de la escena
+    SphereBVH bvh;
+    bvh.build(scene);
+    std::cout << "BVH: " << bvh.nodeCount() << " nodos, profundidad " << bvh.depth() << std::endl;
     Camera camera(SCR_WIDTH, SCR_HEIGHT);
 
     global_cam = &camera;
 
     camera.SetPosition(3.0f, 0.0f, 0.0f);
 
+    std::cout << "Ray packet kernel: " << rayPacketKernelName() << std::endl;
+
     bool running = true;
     SDL_Event event;
     std::vector<Uint32> pixels(SCR_WIDTH * SCR_HEIGHT);
@@ -95,18 +112,41 @@ int main(int argc, char** argv) {
 
     bool show_grid = false;
     bool show_axis = false;
+    // M: tiles y paquetes de rayos en orden Morton en vez de por filas
+    // P: con la cámara quieta cada frame suma una muestra desplazada dentro del
+    // píxel y se muestra la media; moverla vuelve a empezar
+    // (./test7 N morton progressive para empezar así)
+    PixelOrder pixel_order = PixelOrder::RowMajor;
+    bool progressive = false;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "morton") == 0) pixel_order = PixelOrder::Morton;
+        if (std::strcmp(argv[i], "progressive") == 0) progressive = true;
+    }
+    ProgressiveState progressiveState;
+    // suma de las muestras de cada píxel (RGBA32F)
+    std::vector<glm::vec4> accum(SCR_WIDTH * SCR_HEIGHT);
 
     uint64_t startTime = SDL_GetPerformanceCounter();
     uint64_t frequency = SDL_GetPerformanceFrequency();
 
-    while (running) {
+    while (running && app.nextFrame()) {
 
         uint64_t currentFrame = SDL_GetPerformanceCounter();
 		deltaTime = static_cast<double>(currentFrame - lastFrame) / frequency;
 		lastFrame = currentFrame;
-        std::cout << "FPS: " << 1 / deltaTime << std::endl;
+        if (!app.isHeadless())
+            std::cout << "FPS: " << 1 / deltaTime << std::endl;
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_EVENT_QUIT) running = false;
+            if (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_M) {
+                pixel_order = pixel_order == PixelOrder::Morton ? PixelOrder::RowMajor : PixelOrder::Morton;
+                std::cout << "Orden de píxeles: " << pixelOrderName(pixel_order) << std::endl;
+            }
+            if (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_P) {
+                progressive = !progressive;
+                progressiveState.reset();
+                std::cout << "Progresivo: " << (progressive ? "sí" : "no") << std::endl;
+            }
             if (event.type == SDL_EVENT_MOUSE_MOTION) {
                 camera.OnMouse((float) event.motion.x, (float) event.motion.y);
 
@@ -162,7 +202,11 @@ int main(int argc, char** argv) {
         //         pixels[y * SCR_WIDTH + x] = calculatePixel(x, y, sphere);
         //     }
         // }
-        renderImage(pixels, spheres, 3, camera.getView(), resolution, show_grid, show_axis, elapsedTime);
+        // -1: la imagen ya tiene todas las muestras y no hace falta trazar
+        int sample = progressive ? progressiveState.nextSample(camera) : 0;
+        if (sample >= 0)
+            renderImage(pixels, scene, bvh, camera.getView(), resolution, show_grid, show_axis, elapsedTime, pixel_order,
+                        progressive ? &accum : nullptr, sample);
 
         camera.OnRender(deltaTime);
 
@@ -171,47 +215,72 @@ int main(int argc, char** argv) {
         // for (int i = 0; i < pixels.size(); ++i) {
         //     pixelBuffer[i] = vec4ToUint32(pixels[i]);
         // }
+        if (!renderer)
+            continue;
         SDL_UpdateTexture(texture, nullptr, pixels.data(), SCR_WIDTH * sizeof(Uint32));
         SDL_RenderClear(renderer);
         SDL_RenderTexture(renderer, texture, nullptr, nullptr);
         SDL_RenderPresent(renderer);
     }
 
-    SDL_DestroyTexture(texture);
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    // las filas van de arriba hacia abajo, con r en el byte bajo de cada píxel
+    if (!options.output.empty() && !writeRGBA8PPM(options.output, (const unsigned char*)pixels.data(), SCR_WIDTH, SCR_HEIGHT, false))
+        std::cerr << "No se pudo escribir " << options.output << std::endl;
+
+    if (renderer) {
+        SDL_DestroyTexture(texture);
+        SDL_DestroyRenderer(renderer);
+    }
+    app.destroy();
 
     return 0;
 }
 
 
-void renderImage(std::vector<Uint32>& pixels, const glm::vec4* spheres, int sphereCount, const glm::mat4& viewMatrix,
-                const glm::vec2& resolution, bool showGrid, bool showAxis, float iTime) {
-                float aspect = resolution.x / resolution.y;
-    for (int y = 0; y < resolution.y; ++y) {
-        for (int x = 0; x < resolution.x; ++x) {
-            glm::vec2 uv = glm::vec2(x, resolution.y - y) / resolution * 2.0f - 1.0f;
-            uv.x *= aspect;
-
-            glm::vec3 rd = glm::normalize(uv.x * right + uv.y * up + fov * front);
-
-            float tmin = 10000.0f;
-            glm::vec3 color = glm::vec3(0.0f);
-
-            for (int i = 0; i < sphereCount; ++i) {
-                float t = iSphere(ro, rd, spheres[i]);
-                if (t > 0.0f && t < tmin) {
-                    tmin = t;
-                    glm::vec3 pos = ro + t * rd;
-                    glm::vec3 nor = glm::normalize(pos - glm::vec3(spheres[i]));
-                    glm::vec3 lightDir = glm::normalize(glm::vec3(2.0f, 1.4f, -1.0f));
-                    float ndl = glm::dot(nor, lightDir);
-                    color = glm::mix(color, glm::vec3(1.0f, 0.9f, 0.8f) * std::max(ndl, 0.0f), 0.5f);
+void renderImage(std::vector<Uint32>& pixels, const SphereScene& scene, const SphereBVH& bvh, const glm::mat4& viewMatrix,
+                const glm::vec2& resolution, bool showGrid, bool showAxis, float iTime, PixelOrder order,
+                std::vector<glm::vec4>* accum, int sample) {
+    static_assert(DEFAULT_TILE_SIZE <= RayPacket::MAX_RAYS, "una fila del tile debe caber en un paquete");
+    static_assert(PACKET_BLOCK_SIZE * PACKET_BLOCK_SIZE <= RayPacket::MAX_RAYS, "un bloque debe caber en un paquete");
+    float aspect = resolution.x / resolution.y;
+    int width = (int)resolution.x;
+    int height = (int)resolution.y;
+    SphereSceneView spheres = scene.view();
+    // con accum los rayos pasan por (x, y) + jitter y cada píxel muestra la
+    // media de sus muestras; la muestra 0 es el rayo de siempre
+    glm::vec2 jitter = accum ? ProgressiveState::jitter(sample) : glm::vec2(0.0f);
+    float weight = 1.0f / (float)(sample + 1);
+
+    // Cada tile se sombrea en un hilo del pool; los píxeles de un tile no se comparten.
+    // Cada fila del tile (o cada bloque de 8x8 en orden Morton) se traza como un
+    // paquete de rayos (SIMD si la CPU lo permite)
+    renderTiles(ThreadPool::global(), width, height, DEFAULT_TILE_SIZE, [&](const Tile& tile) {
+        RayPacket packet;
+        forEachPacket(tile, order, [&](const Tile& block) {
+            int blockWidth = block.x1 - block.x0;
+            packet.reset(blockWidth * (block.y1 - block.y0));
+            for (int y = block.y0; y < block.y1; ++y) {
+                for (int x = block.x0; x < block.x1; ++x) {
+                    glm::vec2 uv = glm::vec2(x + jitter.x, resolution.y - y - jitter.y) / resolution * 2.0f - 1.0f;
+                    uv.x *= aspect;
+
+                    packet.setDirection((y - block.y0) * blockWidth + x - block.x0, glm::normalize(uv.x * right + uv.y * up + fov * front));
                 }
             }
 
-            pixels[y * (int)resolution.x + x] = vec4ToUint32(glm::vec4(color, 1.0f));
-        }
-    }
+            bvh.tracePacket(packet, ro, spheres);
+
+            for (int y = block.y0; y < block.y1; ++y) {
+                for (int x = block.x0; x < block.x1; ++x) {
+                    glm::vec4 color(packet.color((y - block.y0) * blockWidth + x - block.x0), 1.0f);
+                    if (accum) {
+                        glm::vec4& sum = (*accum)[y * width + x];
+                        sum = sample > 0 ? sum + color : color;
+                        color = sum * weight;
+                    }
+                    pixels[y * width + x] = vec4ToUint32(color);
+                }
+            }
+        });
+    }, order);
 }
\ No newline at end of file
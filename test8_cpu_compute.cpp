@@ -0,0 +1,208 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <glm/glm.hpp>
+#include "shader_c.h"
+#include "camera3.h"
+#include "sphere_scene.h"
+#include "bvh.h"
+#include "frame_params.h"
+#include "pixel_order.h"
+#include "progressive.h"
+
+// Corre los tres compute shaders del repo en la CPU (sin contexto GL) y deja
+// el último frame de cada uno en un .ppm, para máquinas o CI sin GPU.
+// computeSh_test6.cs corre tres veces: con la BVH, con la lista de esferas
+// por tile en memoria compartida (tileCulling) y con los tiles en orden
+// Morton (pixelOrder); las tres deben dar la misma imagen. Después corre en
+// modo progresivo, una muestra por frame: la muestra 0 tiene que coincidir
+// con la imagen normal, y varias muestras con jitter tienen que dar lo mismo
+// con y sin tileCulling. Un frame overlayOnly tras la última muestra no
+// cambia la imagen. Si alguna comprobación falla, sale con código 1.
+// Uso: ./test8 [frames] [esferas]
+
+const int SCR_WIDTH = 800;
+const int SCR_HEIGHT = 600;
+const int TEXTURE_WIDTH = 1000;
+const int TEXTURE_HEIGHT = 1000;
+// muestras progresivas con las que se comparan tiles y BVH
+const int JITTER_SAMPLES = 4;
+
+using Clock = std::chrono::steady_clock;
+
+// Ejecuta frames dispatches y muestra ms por frame; update fija los uniforms de cada frame
+template <typename F>
+void runKernel(const char* name, const ComputeShader& shader, CpuImage& image, int frames, F update) {
+    double totalMs = 0.0;
+    for (int frame = 0; frame < frames; frame++) {
+        update(frame);
+        Clock::time_point start = Clock::now();
+        shader.dispatchFor(image.width(), image.height());
+        totalMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+    double ms = totalMs / frames;
+    std::cout << std::setw(24) << name << std::setw(12) << std::fixed << std::setprecision(2) << ms
+              << std::setw(12) << image.width() * image.height() / ms / 1000.0 << std::endl;
+
+    std::string path = std::string(name) + ".ppm";
+    if (!image.writePPM(path))
+        std::cerr << "No se pudo escribir " << path << std::endl;
+}
+
+// Píxeles en los que dos imágenes del mismo tamaño no coinciden, comparados
+// en RGBA8 como se guardan (el fondo puede tener NaN, que no es igual a sí mismo)
+int differentPixels(const CpuImage& a, const CpuImage& b) {
+    std::vector<unsigned char> pixelsA, pixelsB;
+    a.readRGBA8(pixelsA);
+    b.readRGBA8(pixelsB);
+    int count = 0;
+    for (size_t i = 0; i < pixelsA.size(); i += 4)
+        if (std::memcmp(&pixelsA[i], &pixelsB[i], 4) != 0)
+            count++;
+    return count;
+}
+
+// Muestra cuántos píxeles difieren y si la comprobación falla (alguno distinto)
+bool sameImage(const char* check, const CpuImage& a, const CpuImage& b) {
+    int count = differentPixels(a, b);
+    std::cout << check << ": " << count << " píxeles distintos" << (count ? "  FALLO" : "") << std::endl;
+    return count == 0;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10;
+
+    bool ok = true;
+    std::cout << "threads: " << ThreadPool::global().size() << ", " << frames << " frames" << std::endl;
+    std::cout << std::setw(24) << "kernel" << std::setw(12) << "ms/frame" << std::setw(12) << "Mpix/s" << std::endl;
+
+    // computeShader.cs, igual que main.cpp
+    {
+        ComputeShader computeShader("computeShader.cs", ComputeBackend::CPU);
+        CpuImage image(TEXTURE_WIDTH, TEXTURE_HEIGHT, GL_RGBA32F);
+        computeShader.bindImage(0, &image);
+        runKernel("computeShader", computeShader, image, frames, [&](int frame) {
+            computeShader.setFloat("t", frame / 60.0f);
+        });
+    }
+
+    // computeShader2.cs, igual que test3.cpp con la luz en el centro
+    {
+        ComputeShader computeShader("computeShader2.cs", ComputeBackend::CPU);
+        CpuImage image(SCR_WIDTH, SCR_HEIGHT, GL_RGBA8);
+        computeShader.bindImage(0, &image);
+        runKernel("computeShader2", computeShader, image, frames, [&](int) {
+            computeShader.setInt("SCR_WIDTH", SCR_WIDTH);
+            computeShader.setInt("SCR_HEIGHT", SCR_HEIGHT);
+            computeShader.setVec2I("lightPos", SCR_WIDTH / 2, SCR_HEIGHT / 2);
+            computeShader.setFloat("lightIntensity", 5.0f);
+            computeShader.setVec4("baseColor", glm::vec4(0.2f, 0.5f, 0.8f, 1.0f));
+        });
+    }
+
+    // computeSh_test6.cs, igual que test6 con la cámara inicial
+    {
+        ComputeShader computeShader("computeSh_test6.cs", ComputeBackend::CPU);
+        CpuImage image(SCR_WIDTH, SCR_HEIGHT, GL_RGBA8);
+        CpuImage tiledImage(SCR_WIDTH, SCR_HEIGHT, GL_RGBA8);
+        CpuImage mortonImage(SCR_WIDTH, SCR_HEIGHT, GL_RGBA8);
+        CpuImage progressiveImage(SCR_WIDTH, SCR_HEIGHT, GL_RGBA8);
+        CpuImage accumImage(SCR_WIDTH, SCR_HEIGHT, GL_RGBA32F);
+
+        SphereScene scene = argc > 2 ? SphereScene::random(std::atoi(argv[2])) : SphereScene::defaultScene();
+        SphereBVH bvh;
+        bvh.build(scene);
+
+        // mismos buffers que sube SphereScene::upload (centros como vec4 por std430)
+        SphereSceneView view = scene.view();
+        std::vector<glm::vec4> centers(scene.size());
+        for (int i = 0; i < scene.size(); i++)
+            centers[i] = glm::vec4(view.center(i), 1.0f);
+        computeShader.bindBuffer(SphereScene::CENTERS_BINDING, centers.data(), centers.size() * sizeof(glm::vec4));
+        computeShader.bindBuffer(SphereScene::RADII_BINDING, view.radius, scene.size() * sizeof(float));
+        computeShader.bindBuffer(SphereBVH::NODES_BINDING, bvh.getNodes().data(), bvh.getNodes().size() * sizeof(BVHNode));
+
+        Camera camera(SCR_WIDTH, SCR_HEIGHT);
+        camera.SetPosition(3.0f, 0.0f, 0.0f);
+
+        // mismo bloque std140 que sube test6 a su UBO
+        FrameParams params = {};
+        computeShader.bindUniformBuffer(FrameParams::BINDING, &params);
+
+        auto update = [&](int frame) {
+            params.viewMatrix = camera.getView();
+            params.front = camera.getFront();
+            params.up = camera.getUp();
+            params.right = camera.getRight();
+            params.cameraPos = camera.getPosition();
+            params.screenResolution = glm::vec2(SCR_WIDTH, SCR_HEIGHT);
+            params.iTime = frame / 60.0f;
+            params.FOV = camera.getFov();
+            params.sphereCount = scene.size();
+            params.showGrid = true;
+            params.showAxis = true;
+        };
+        computeShader.bindImage(0, &image);
+        computeShader.setBool("tileCulling", false);
+        runKernel("computeSh_test6", computeShader, image, frames, update);
+
+        computeShader.bindImage(0, &tiledImage);
+        computeShader.setBool("tileCulling", true);
+        runKernel("computeSh_test6_tiles", computeShader, tiledImage, frames, update);
+
+        computeShader.bindImage(0, &mortonImage);
+        computeShader.setInt("pixelOrder", (int)PixelOrder::Morton);
+        runKernel("computeSh_test6_morton", computeShader, mortonImage, frames, update);
+
+        ok = sameImage("tiles vs BVH", image, tiledImage) && ok;
+        ok = sameImage("Morton vs filas", tiledImage, mortonImage) && ok;
+
+        // la cámara no se mueve: cada frame es la muestra siguiente
+        computeShader.bindImage(0, &progressiveImage);
+        computeShader.bindImage(1, &accumImage);
+        computeShader.setBool("progressive", true);
+        auto progressiveUpdate = [&](int frame) {
+            update(frame);
+            computeShader.setInt("sampleIndex", frame);
+            computeShader.setVec2("sampleJitter", ProgressiveState::jitter(frame));
+        };
+        runKernel("computeSh_test6_accum", computeShader, progressiveImage, frames, progressiveUpdate);
+        progressiveUpdate(0);
+        computeShader.dispatchFor(SCR_WIDTH, SCR_HEIGHT);
+        ok = sameImage("muestra 0 vs normal", tiledImage, progressiveImage) && ok;
+
+        // con jitter los rayos salen del píxel: el cono del tile tiene que cubrirlo
+        CpuImage jitteredImage(SCR_WIDTH, SCR_HEIGHT, GL_RGBA8);
+        CpuImage jitteredAccum(SCR_WIDTH, SCR_HEIGHT, GL_RGBA32F);
+        computeShader.bindImage(0, &jitteredImage);
+        computeShader.bindImage(1, &jitteredAccum);
+        computeShader.setBool("tileCulling", false);
+        for (int sample = 0; sample < JITTER_SAMPLES; sample++) {
+            progressiveUpdate(sample);
+            computeShader.dispatchFor(SCR_WIDTH, SCR_HEIGHT);
+        }
+        computeShader.bindImage(0, &progressiveImage);
+        computeShader.bindImage(1, &accumImage);
+        computeShader.setBool("tileCulling", true);
+        for (int sample = 0; sample < JITTER_SAMPLES; sample++) {
+            progressiveUpdate(sample);
+            computeShader.dispatchFor(SCR_WIDTH, SCR_HEIGHT);
+        }
+        ok = sameImage("tiles vs BVH con jitter", jitteredImage, progressiveImage) && ok;
+
+        // ya convergida, overlayOnly no traza: con el mismo iTime sale la misma imagen
+        computeShader.bindImage(0, &jitteredImage);
+        progressiveUpdate(JITTER_SAMPLES - 1);
+        computeShader.setBool("overlayOnly", true);
+        computeShader.dispatchFor(SCR_WIDTH, SCR_HEIGHT);
+        computeShader.setBool("overlayOnly", false);
+        ok = sameImage("solo overlay vs última muestra", progressiveImage, jitteredImage) && ok;
+    }
+
+    if (!ok)
+        std::cerr << "FALLO: computeSh_test6.cs no da la misma imagen en todos los modos" << std::endl;
+    return ok ? 0 : 1;
+}
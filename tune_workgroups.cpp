@@ -0,0 +1,155 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+#include "app_context.h"
+#include "workgroup_tuner.h"
+#include "output_image.h"
+#include "camera3.h"
+#include "sphere_scene.h"
+#include "bvh.h"
+#include "frame_params.h"
+#include "uniform_ring.h"
+
+// Busca el local_size más rápido de cada compute shader del repo en este
+// dispositivo y lo guarda en workgroup_sizes.txt; main, test3 y test6 lo leen al
+// arrancar. Con --cpu prueba los tamaños sobre los ports de C++ (sin GPU).
+// Uso: ./tune_workgroups [--cpu] [--repeats N] [--headless]
+
+const int SCR_WIDTH = 800;
+const int SCR_HEIGHT = 600;
+const int TEXTURE_WIDTH = 1000;
+const int TEXTURE_HEIGHT = 1000;
+
+// la imagen de salida con el formato que usa la aplicación; los candidatos se compilan con él
+void createImage(OutputImage& image, WorkgroupTuner& tuner, int width, int height, ImageFormat format, bool gpu) {
+    tuner.setDefines(imageFormatDefines(format));
+    if (!gpu)
+        return;
+    image.create(width, height, format);
+    image.bindImage(0);
+}
+
+void report(const char* kernel, const WorkgroupTuner& tuner, const WorkgroupSize& best) {
+    std::cout << kernel << std::endl;
+    for (const WorkgroupTuner::Result& r : tuner.results()) {
+        std::cout << std::setw(8) << (std::to_string(r.local.x) + "x" + std::to_string(r.local.y))
+                  << std::setw(10) << std::fixed << std::setprecision(3) << r.ms << " ms"
+                  << (r.local == best.local ? "  <-" : "") << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    RunOptions options = RunOptions::parse(argc, argv);
+    ComputeBackend backend = ComputeBackend::GL;
+    int repeats = WorkgroupTuner::DEFAULT_REPEATS;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--cpu") == 0)
+            backend = ComputeBackend::CPU;
+        else if (std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc)
+            repeats = std::atoi(argv[++i]);
+    }
+    bool gpu = backend == ComputeBackend::GL;
+
+    AppContext app;
+    if (gpu && !app.create("tune_workgroups", 64, 64, options))
+        return -1;
+
+    WorkgroupTuner tuner(backend);
+    tuner.setRepeats(gpu ? repeats : std::max(1, repeats / 10));
+    std::cout << "Dispositivo: " << tuner.deviceName() << std::endl;
+
+    // computeShader.cs, igual que main.cpp
+    {
+        OutputImage output;
+        createImage(output, tuner, TEXTURE_WIDTH, TEXTURE_HEIGHT, ImageFormat::RGBA8, gpu);
+        CpuImage image(TEXTURE_WIDTH, TEXTURE_HEIGHT, GL_RGBA8);
+        WorkgroupSize best = tuner.tune("computeShader.cs", TEXTURE_WIDTH, TEXTURE_HEIGHT, [&](ComputeShader& shader) {
+            shader.bindImage(0, &image);
+            shader.use();
+            shader.setFloat("t", 1.0f);
+        });
+        report("computeShader.cs", tuner, best);
+        output.release();
+    }
+
+    // computeShader2.cs, igual que test3.cpp
+    {
+        OutputImage output;
+        createImage(output, tuner, SCR_WIDTH, SCR_HEIGHT, ImageFormat::RGBA8, gpu);
+        CpuImage image(SCR_WIDTH, SCR_HEIGHT, GL_RGBA8);
+        WorkgroupSize best = tuner.tune("computeShader2.cs", SCR_WIDTH, SCR_HEIGHT, [&](ComputeShader& shader) {
+            shader.bindImage(0, &image);
+            shader.use();
+            shader.setInt("SCR_WIDTH", SCR_WIDTH);
+            shader.setInt("SCR_HEIGHT", SCR_HEIGHT);
+            shader.setVec2I("lightPos", SCR_WIDTH / 2, SCR_HEIGHT / 2);
+            shader.setFloat("lightIntensity", 5.0f);
+            shader.setVec4("baseColor", glm::vec4(0.2f, 0.5f, 0.8f, 1.0f));
+        });
+        report("computeShader2.cs", tuner, best);
+        output.release();
+    }
+
+    // computeSh_test6.cs, igual que test6 con la cámara inicial
+    {
+        OutputImage output;
+        createImage(output, tuner, SCR_WIDTH, SCR_HEIGHT, ImageFormat::RGBA8, gpu);
+        CpuImage image(SCR_WIDTH, SCR_HEIGHT, GL_RGBA8);
+
+        SphereScene scene = SphereScene::defaultScene();
+        SphereBVH bvh;
+        bvh.build(scene);
+
+        Camera camera(SCR_WIDTH, SCR_HEIGHT);
+        camera.SetPosition(3.0f, 0.0f, 0.0f);
+        FrameParams params = {};
+        params.viewMatrix = camera.getView();
+        params.front = camera.getFront();
+        params.up = camera.getUp();
+        params.right = camera.getRight();
+        params.cameraPos = camera.getPosition();
+        params.screenResolution = glm::vec2(SCR_WIDTH, SCR_HEIGHT);
+        params.FOV = camera.getFov();
+        params.sphereCount = scene.size();
+        params.showGrid = true;
+        params.showAxis = true;
+
+        // en GL los buffers quedan enlazados al contexto; en la CPU cada programa los enlaza
+        UniformRing frameParamsRing;
+        std::vector<glm::vec4> centers(scene.size());
+        SphereSceneView view = scene.view();
+        for (int i = 0; i < scene.size(); i++)
+            centers[i] = glm::vec4(view.center(i), 1.0f);
+        if (gpu) {
+            scene.upload();
+            bvh.upload();
+            frameParamsRing.create(FrameParams::BINDING, sizeof(FrameParams));
+            frameParamsRing.write(&params);
+        }
+
+        WorkgroupSize best = tuner.tune("computeSh_test6.cs", SCR_WIDTH, SCR_HEIGHT, [&](ComputeShader& shader) {
+            shader.bindImage(0, &image);
+            shader.bindBuffer(SphereScene::CENTERS_BINDING, centers.data(), centers.size() * sizeof(glm::vec4));
+            shader.bindBuffer(SphereScene::RADII_BINDING, view.radius, scene.size() * sizeof(float));
+            shader.bindBuffer(SphereBVH::NODES_BINDING, bvh.getNodes().data(), bvh.getNodes().size() * sizeof(BVHNode));
+            shader.bindUniformBuffer(FrameParams::BINDING, &params);
+        });
+        report("computeSh_test6.cs", tuner, best);
+
+        if (gpu) {
+            frameParamsRing.release();
+            bvh.release();
+            scene.release();
+        }
+        output.release();
+    }
+
+    std::cout << "Guardado en " << WorkgroupTuner::DEFAULT_TABLE << std::endl;
+    if (gpu)
+        app.destroy();
+    return 0;
+}